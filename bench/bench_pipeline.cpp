@@ -0,0 +1,536 @@
+// hermetic end-to-end benchmark for the karaoke pipeline.
+//
+// every external service is replaced by a local stand-in:
+//   yt-dlp    -> shell script that prints canned metadata and copies a generated wav
+//   lrclib    -> in-process http server returning canned synced lyrics
+//   separator -> shell script that sleeps for a tunable delay, then copies its input
+//   ffmpeg    -> stub that touches the output, or the real binary with --ffmpeg
+//
+// per-stage and end-to-end latency plus batch throughput are compared against
+// a stored baseline, and the exit code is non-zero on a regression.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <limits>
+#include <type_traits>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include <Pipeline.hpp>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+struct BenchConfig {
+        int iterations = 5;             // sequential end-to-end runs (after one warmup)
+        int batch_size = 4;             // concurrent jobs for the throughput run
+        double audio_seconds = 30.0;    // length of the generated song
+        double separator_delay = 0.5;   // seconds the stub separator sleeps
+        int lyrics_delay_ms = 0;        // artificial latency of the lrclib stand-in
+        std::string ffmpeg = "stub";    // "stub" or a path / name of a real ffmpeg
+        fs::path work_dir = "bench_work";
+        fs::path baseline_path = "bench/baselines.json";
+        double tolerance = 0.25;        // allowed relative slowdown before failing
+        double min_delta = 0.05;        // ignore slowdowns smaller than this (seconds)
+        bool update_baseline = false;
+        bool verbose = false;
+    };
+
+// --stand-ins--
+
+void write_wav(const fs::path& path, double seconds) {
+    const uint32_t sample_rate = 44100;
+    const uint16_t channels = 2;
+    const uint16_t bits = 16;
+    uint32_t frames = static_cast<uint32_t>(seconds * sample_rate);
+    uint32_t data_size = frames * channels * (bits / 8);
+
+    std::ofstream out(path, std::ios::binary);
+
+    auto put32 = [&](uint32_t v) { out.write(reinterpret_cast<const char*>(&v), 4); };
+    auto put16 = [&](uint16_t v) { out.write(reinterpret_cast<const char*>(&v), 2); };
+
+    out.write("RIFF", 4); put32(36 + data_size); out.write("WAVE", 4);
+    out.write("fmt ", 4); put32(16); put16(1); put16(channels); put32(sample_rate);
+    put32(sample_rate * channels * (bits / 8)); put16(channels * (bits / 8)); put16(bits);
+    out.write("data", 4); put32(data_size);
+
+    // 440hz tone, same sample on both channels
+    for (uint32_t i = 0; i < frames; ++i) {
+        int16_t sample = static_cast<int16_t>(8000 * std::sin(2.0 * M_PI * 440.0 * i / sample_rate));
+        put16(static_cast<uint16_t>(sample));
+        put16(static_cast<uint16_t>(sample));
+    }
+}
+
+void write_script(const fs::path& path, const std::string& body) {
+    std::ofstream out(path);
+    out << "#!/bin/sh\n" << body;
+    out.close();
+    fs::permissions(path, fs::perms::owner_all | fs::perms::group_read | fs::perms::group_exec,
+                    fs::perm_options::replace);
+}
+
+// canned lrclib response covering the whole generated song, with a mix of
+// line level and word level timestamps
+std::string canned_lrclib_json(double audio_seconds) {
+    std::stringstream lrc;
+    int line = 0;
+
+    for (double t = 1.0; t + 2.5 < audio_seconds; t += 2.5, ++line) {
+        auto stamp = [](double s) {
+            char buffer[16];
+            snprintf(buffer, sizeof(buffer), "%02d:%05.2f", static_cast<int>(s) / 60, std::fmod(s, 60.0));
+            return std::string(buffer);
+        };
+
+        if (line % 2 == 0) {
+            lrc << "[" << stamp(t) << "]benchmark line number " << line << "\n";
+        } else {
+            lrc << "[" << stamp(t) << "]"
+                << "<" << stamp(t) << ">word <" << stamp(t + 0.6) << ">level <"
+                << stamp(t + 1.2) << ">line <" << stamp(t + 1.8) << ">" << line << "\n";
+        }
+    }
+
+    json body = {{"syncedLyrics", lrc.str()}, {"plainLyrics", "benchmark"}};
+    return body.dump();
+}
+
+// minimal http/1.1 server answering every request with the same json body
+class LrclibStandIn {
+public:
+    LrclibStandIn(std::string body, int delay_ms) : body_(std::move(body)), delay_ms_(delay_ms) {}
+
+    ~LrclibStandIn() { stop(); }
+
+    bool start() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) return false;
+
+        int reuse = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0; // let the kernel pick a free port
+
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listen_fd_, 64) < 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            return false;
+        }
+
+        port_ = ntohs(addr.sin_port);
+        running_ = true;
+        thread_ = std::thread([this]() { serve(); });
+        return true;
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) return;
+        shutdown(listen_fd_, SHUT_RDWR); // unblocks accept()
+        close(listen_fd_);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    std::string base_url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+private:
+    std::string body_;
+    int delay_ms_ = 0;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    void serve() {
+        while (running_) {
+            int client = accept(listen_fd_, nullptr, nullptr);
+            if (client < 0) continue;
+
+            // read until the end of the request headers; the body is ignored
+            std::string request;
+            char buffer[4096];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                ssize_t n = read(client, buffer, sizeof(buffer));
+                if (n <= 0) break;
+                request.append(buffer, n);
+            }
+
+            if (delay_ms_ > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+
+            std::stringstream response;
+            response << "HTTP/1.1 200 OK\r\n"
+                     << "Content-Type: application/json\r\n"
+                     << "Content-Length: " << body_.size() << "\r\n"
+                     << "Connection: close\r\n\r\n"
+                     << body_;
+
+            std::string out = response.str();
+            size_t sent = 0;
+            while (sent < out.size()) {
+                ssize_t n = write(client, out.data() + sent, out.size() - sent);
+                if (n <= 0) break;
+                sent += n;
+            }
+            close(client);
+        }
+    }
+};
+
+// --harness--
+
+struct Sandbox {
+    Paths paths;
+    fs::path state_dir;
+};
+
+// present in every work dir the bench created, so it only ever wipes its own
+const char* sandbox_marker = ".karaoke_bench";
+
+std::optional<Sandbox> prepare_sandbox(const BenchConfig& config) {
+    std::error_code ec;
+    bool has_content = fs::exists(config.work_dir) && !fs::is_empty(config.work_dir, ec);
+    if (has_content && !fs::exists(config.work_dir / sandbox_marker)) {
+        std::cerr << "refusing to clear " << config.work_dir
+                  << ": it was not created by karaoke_bench (missing " << sandbox_marker << ")" << std::endl;
+        return std::nullopt;
+    }
+    fs::remove_all(config.work_dir);
+
+    fs::path bin = config.work_dir / "bin";
+    fs::create_directories(bin);
+    std::ofstream(config.work_dir / sandbox_marker).put('\n');
+
+    fs::path wav = fs::absolute(config.work_dir / "song.wav");
+    write_wav(wav, config.audio_seconds);
+
+    // the track name echoes the query so concurrent jobs get distinct output files
+    write_script(bin / "yt-dlp",
+        "out=\"\"\n"
+        "query=\"\"\n"
+        "while [ $# -gt 0 ]; do\n"
+        "  case \"$1\" in\n"
+        "    --output) out=\"$2\"; shift 2 ;;\n"
+        "    --print|--postprocessor-args|--audio-format) shift 2 ;;\n"
+        "    *) query=\"$1\"; shift ;;\n"
+        "  esac\n"
+        "done\n"
+        "if [ -n \"$out\" ]; then exec cp \"" + wav.string() + "\" \"$out\"; fi\n"
+        "track=\"${query#ytsearch1:}\"\n"
+        "printf 'Bench Artist\\n%s\\nBench Artist - %s\\n' \"$track\" \"$track\"\n");
+
+    std::stringstream separator;
+    separator << "sleep " << config.separator_delay << "\n"
+              << "exec cp \"$1\" \"$2\"\n";
+    write_script(bin / "separator", separator.str());
+
+    Sandbox sandbox;
+    sandbox.paths.ytdlp_binary = fs::absolute(bin / "yt-dlp");
+    sandbox.paths.separator_binary = fs::absolute(bin / "separator");
+
+    if (config.ffmpeg == "stub") {
+        write_script(bin / "ffmpeg",
+            "for arg in \"$@\"; do last=\"$arg\"; done\n"
+            "exec touch \"$last\"\n");
+        sandbox.paths.ffmpeg_binary = fs::absolute(bin / "ffmpeg");
+    } else {
+        sandbox.paths.ffmpeg_binary = config.ffmpeg;
+    }
+
+    sandbox.paths.temp_dir = config.work_dir / "temp";
+    sandbox.paths.output_dir = config.work_dir / "output";
+    sandbox.paths.artifacts_dir = config.work_dir / "artifacts";
+    sandbox.state_dir = config.work_dir / "governor";
+    return sandbox;
+}
+
+PipelineResult run_job(const Sandbox& sandbox, const std::string& lyrics_url, const std::string& input) {
+    GovernorConfig governor;
+    governor.state_dir = sandbox.state_dir;
+
+    ExternalTools tools(sandbox.paths, governor);
+    LyricsFetcher lyrics_fetcher(lyrics_url);
+    AssConverter ass_converter;
+
+    return run_pipeline(input, PipelineOptions(), tools, lyrics_fetcher, ass_converter);
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(std::ceil(p * values.size())) - 1;
+    return values[std::min(index, values.size() - 1)];
+}
+
+json summarize(const std::vector<double>& values) {
+    return {{"median", percentile(values, 0.5)}, {"p95", percentile(values, 0.95)}};
+}
+
+// --baseline comparison--
+
+bool compare_with_baseline(const json& results, const json& baseline, const BenchConfig& config) {
+    if (baseline.value("config", json::object()) != results["config"]) {
+        std::cerr << "warning: baseline was recorded with a different config; comparing anyway" << std::endl;
+    }
+
+    bool regressed = false;
+
+    auto check_latency = [&](const std::string& name, double current, double base) {
+        double limit = base * (1.0 + config.tolerance);
+        bool bad = current > limit && (current - base) > config.min_delta;
+        regressed = regressed || bad;
+
+        printf("  %-22s %9.4fs  baseline %9.4fs  %s\n", name.c_str(), current, base, bad ? "REGRESSION" : "ok");
+    };
+
+    std::cout << "\ncomparison (tolerance " << config.tolerance * 100 << "%):" << std::endl;
+
+    for (auto& [stage, stats] : results["stages"].items()) {
+        if (!baseline["stages"].contains(stage)) continue;
+        check_latency(stage, stats["median"], baseline["stages"][stage]["median"]);
+    }
+
+    if (baseline.contains("end_to_end")) {
+        check_latency("end_to_end", results["end_to_end"]["median"], baseline["end_to_end"]["median"]);
+    }
+
+    if (baseline.contains("batch")) {
+        double current = results["batch"]["jobs_per_second"];
+        double base = baseline["batch"]["jobs_per_second"];
+        bool bad = current < base * (1.0 - config.tolerance);
+        regressed = regressed || bad;
+
+        printf("  %-22s %9.4f/s baseline %9.4f/s %s\n", "batch_throughput", current, base, bad ? "REGRESSION" : "ok");
+    }
+
+    return !regressed;
+}
+
+// strict numeric flag values: the whole string must parse, and no flag
+// takes a negative or non-finite value
+template <typename T>
+std::optional<T> parse_number(const std::string& text) {
+    try {
+        size_t used = 0;
+        T value;
+        if constexpr (std::is_floating_point_v<T>) {
+            double parsed = std::stod(text, &used);
+            if (!std::isfinite(parsed) || parsed < 0.0) return std::nullopt;
+            value = static_cast<T>(parsed);
+        } else {
+            if (!text.empty() && text[0] == '-') return std::nullopt;
+            unsigned long parsed = std::stoul(text, &used);
+            if (parsed > static_cast<unsigned long>(std::numeric_limits<T>::max())) return std::nullopt;
+            value = static_cast<T>(parsed);
+        }
+        if (used != text.size()) return std::nullopt;
+        return value;
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+void print_usage() {
+    std::cout << "usage: ./karaoke_bench [--iterations n] [--batch n] [--audio-seconds s] "
+              << "[--separator-delay s] [--lyrics-delay-ms ms] [--ffmpeg stub|<path>] "
+              << "[--work-dir dir] [--baseline file] [--tolerance fraction] "
+              << "[--update-baseline] [--verbose]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+
+    // parses into target, enforcing a lower bound; reports and fails on a bad value
+    auto number_arg = [](const std::string& flag, const std::string& text, auto& target, auto min) {
+        auto value = parse_number<std::decay_t<decltype(target)>>(text);
+        if (!value || *value < min) {
+            std::cerr << "invalid value for " << flag << ": " << text << std::endl;
+            print_usage();
+            return false;
+        }
+        target = *value;
+        return true;
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (arg == "--iterations" && has_value) {
+            if (!number_arg(arg, argv[++i], config.iterations, 1)) return 1;
+        } else if (arg == "--batch" && has_value) {
+            if (!number_arg(arg, argv[++i], config.batch_size, 1)) return 1;
+        } else if (arg == "--audio-seconds" && has_value) {
+            if (!number_arg(arg, argv[++i], config.audio_seconds, 1.0)) return 1;
+        } else if (arg == "--separator-delay" && has_value) {
+            if (!number_arg(arg, argv[++i], config.separator_delay, 0.0)) return 1;
+        } else if (arg == "--lyrics-delay-ms" && has_value) {
+            if (!number_arg(arg, argv[++i], config.lyrics_delay_ms, 0)) return 1;
+        } else if (arg == "--ffmpeg" && has_value) {
+            config.ffmpeg = argv[++i];
+        } else if (arg == "--work-dir" && has_value) {
+            config.work_dir = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            config.baseline_path = argv[++i];
+        } else if (arg == "--tolerance" && has_value) {
+            if (!number_arg(arg, argv[++i], config.tolerance, 0.0)) return 1;
+        } else if (arg == "--update-baseline") {
+            config.update_baseline = true;
+        } else if (arg == "--verbose") {
+            config.verbose = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    auto sandbox_opt = prepare_sandbox(config);
+    if (!sandbox_opt) return 1;
+    const Sandbox& sandbox = *sandbox_opt;
+
+    LrclibStandIn lrclib(canned_lrclib_json(config.audio_seconds), config.lyrics_delay_ms);
+    if (!lrclib.start()) {
+        std::cerr << "failed to start lrclib stand-in" << std::endl;
+        return 1;
+    }
+
+    // pipeline logging is noise here unless asked for. stdout itself is
+    // pointed at /dev/null so the tools and the forked batch jobs stay quiet too
+    std::cout.flush();
+    int saved_stdout = -1;
+    if (!config.verbose) {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) {
+            saved_stdout = dup(STDOUT_FILENO);
+            dup2(devnull, STDOUT_FILENO);
+            close(devnull);
+        }
+    }
+
+    // every job gets a unique input so nothing is served from the artifact cache
+    int job_counter = 0;
+    auto next_input = [&]() { return "bench song " + std::to_string(job_counter++); };
+
+    bool failed = false;
+
+    // 1. sequential latency (first run is a warmup)
+    std::map<std::string, std::vector<double>> stage_samples;
+    std::vector<double> totals;
+
+    for (int i = 0; i <= config.iterations; ++i) {
+        PipelineResult result = run_job(sandbox, lrclib.base_url(), next_input());
+        failed = failed || !result.success;
+        if (i == 0) continue;
+
+        for (const auto& stage : result.stages) stage_samples[stage.stage].push_back(stage.seconds);
+        totals.push_back(result.total_seconds);
+    }
+
+    // 2. batch throughput. each job is its own process, like concurrent
+    // karaoke runs on one host, so they share the governor through its state file
+    std::vector<pid_t> workers;
+    std::vector<std::string> batch_inputs;
+    for (int i = 0; i < config.batch_size; ++i) batch_inputs.push_back(next_input());
+
+    std::cout.flush();
+    auto batch_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.batch_size; ++i) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "fork failed: " << std::strerror(errno) << std::endl;
+            failed = true;
+            break;
+        }
+        if (pid == 0) {
+            bool ok = run_job(sandbox, lrclib.base_url(), batch_inputs[i]).success;
+            std::cout.flush();
+            _exit(ok ? 0 : 1);
+        }
+        workers.push_back(pid);
+    }
+    for (pid_t pid : workers) {
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    double batch_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+
+    std::cout.flush();
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+    lrclib.stop();
+
+    // 3. report
+    json results;
+    results["config"] = {{"iterations", config.iterations},
+                         {"batch_size", config.batch_size},
+                         {"audio_seconds", config.audio_seconds},
+                         {"separator_delay", config.separator_delay},
+                         {"lyrics_delay_ms", config.lyrics_delay_ms},
+                         {"ffmpeg", config.ffmpeg == "stub" ? "stub" : "real"}};
+
+    results["stages"] = json::object();
+    for (const auto& [stage, samples] : stage_samples) results["stages"][stage] = summarize(samples);
+
+    results["end_to_end"] = summarize(totals);
+    results["batch"] = {{"jobs", config.batch_size},
+                        {"seconds", batch_seconds},
+                        {"jobs_per_second", config.batch_size / batch_seconds}};
+
+    std::cout << "results:\n" << results.dump(2) << std::endl;
+
+    if (failed) {
+        std::cerr << "one or more pipeline runs failed" << std::endl;
+        return 1;
+    }
+
+    if (config.update_baseline) {
+        if (config.baseline_path.has_parent_path()) fs::create_directories(config.baseline_path.parent_path());
+        std::ofstream out(config.baseline_path);
+        out << results.dump(2) << "\n";
+        std::cout << "baseline written to " << config.baseline_path << std::endl;
+        return 0;
+    }
+
+    std::ifstream baseline_in(config.baseline_path);
+    if (!baseline_in.is_open()) {
+        std::cerr << "no baseline at " << config.baseline_path << " (run with --update-baseline)" << std::endl;
+        return 0;
+    }
+
+    json baseline;
+    try {
+        baseline = json::parse(baseline_in);
+    } catch (const std::exception& e) {
+        std::cerr << "failed to parse baseline: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return compare_with_baseline(results, baseline, config) ? 0 : 1;
+}
@@ -5,6 +5,15 @@
 #include <array>
 #include <memory>
 #include <regex>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <poll.h>
 
 namespace fs = std::filesystem;
 
@@ -35,10 +44,189 @@ std::string ExternalTools::run_command_with_output(const std::string& cmd) {
 
 }
 
-bool ExternalTools::execute_command(const std::string& cmd) {
-    std::cout << "[exec]" << cmd << std::endl;
-    int ret = std::system(cmd.c_str());
-    return (ret == 0);
+std::string ExternalTools::ffmpeg_progress_args() const {
+    return reporting() ? "-progress pipe:1 -nostats " : "";
+}
+
+void ExternalTools::pump_output(int out_fd, int err_fd, bool echo_stdout, ProgressParser& parser) {
+    struct Stream {
+        int fd;
+        int echo_fd;        // -1 to swallow the stream
+        std::string partial;
+    };
+
+    Stream streams[2] = {{out_fd, echo_stdout ? STDOUT_FILENO : -1, ""},
+                         {err_fd, STDERR_FILENO, ""}};
+
+    auto report = [&](const std::optional<ProgressEvent>& event) {
+        if (event) progress_->emit(*event);
+    };
+
+    std::array<char, 4096> buffer;
+
+    while (streams[0].fd >= 0 || streams[1].fd >= 0) {
+        pollfd fds[2];
+        for (int i = 0; i < 2; ++i) {
+            fds[i].fd = streams[i].fd; // negative fds are ignored by poll
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        // wake up in time for held back updates and heartbeats of quiet children
+        int ready = poll(fds, 2, parser.next_wakeup_ms());
+        if (ready < 0 && errno != EINTR) {
+            // stop reading, but close the read ends so a chatty child gets
+            // EPIPE instead of blocking on a full pipe while we wait for it
+            std::cerr << "[error] poll failed: " << std::strerror(errno) << std::endl;
+            for (Stream& stream : streams) {
+                if (stream.fd >= 0) close(stream.fd);
+                stream.fd = -1;
+            }
+            break;
+        }
+
+        report(parser.heartbeat());
+        if (ready <= 0) continue;
+
+        for (int i = 0; i < 2; ++i) {
+            Stream& stream = streams[i];
+            if (stream.fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            ssize_t n = read(stream.fd, buffer.data(), buffer.size());
+            if (n <= 0) {
+                if (!stream.partial.empty()) report(parser.feed(stream.partial));
+                close(stream.fd);
+                stream.fd = -1;
+                continue;
+            }
+
+            if (stream.echo_fd >= 0) {
+                ssize_t ignored = write(stream.echo_fd, buffer.data(), n);
+                (void)ignored;
+            }
+
+            // progress bars redraw with \r, so treat it as a line break too
+            for (ssize_t j = 0; j < n; ++j) {
+                char c = buffer[j];
+                if (c == '\n' || c == '\r') {
+                    if (!stream.partial.empty()) report(parser.feed(stream.partial));
+                    stream.partial.clear();
+                } else {
+                    stream.partial += c;
+                }
+            }
+        }
+    }
+}
+
+bool ExternalTools::execute_command(const std::string& cmd, JobKind kind, const std::string& label,
+                                    std::optional<double> duration_hint, size_t units) {
+    bool report = reporting();
+
+    // while reporting, the child's stdout and stderr come back through pipes.
+    // cloexec keeps them out of every other child; dup2 clears it on the copies
+    int out_pipe[2] = {-1, -1};
+    int err_pipe[2] = {-1, -1};
+    auto close_pipes = [&]() {
+        for (int* p : {out_pipe, err_pipe}) {
+            for (int i = 0; i < 2; ++i) {
+                if (p[i] >= 0) close(p[i]);
+                p[i] = -1;
+            }
+        }
+    };
+
+    bool capture = report;
+    if (capture && (pipe2(out_pipe, O_CLOEXEC) < 0 || pipe2(err_pipe, O_CLOEXEC) < 0)) {
+        std::cerr << "[error] failed to create output pipes, progress limited to start and end" << std::endl;
+        close_pipes();
+        capture = false;
+    }
+
+    // without a pipe to read it, the -progress stream would go to the terminal
+    std::string command = cmd;
+    std::string progress_args = ffmpeg_progress_args();
+    if (!capture && !progress_args.empty()) {
+        for (size_t pos; (pos = command.find(progress_args)) != std::string::npos;) {
+            command.erase(pos, progress_args.size());
+        }
+    }
+
+    // only sent when the governor actually makes the job wait
+    std::string ticket = governor_.acquire(kind, units, [&]() {
+        if (!report) return;
+
+        ProgressEvent queued;
+        queued.stage = job_kind_name(kind);
+        queued.status = "queued";
+        queued.label = label;
+        progress_->emit(queued);
+    });
+
+    std::cout << "[exec]" << command << std::endl;
+
+    ProgressParser parser(kind, label, duration_hint);
+    if (report) progress_->emit(parser.make_event("start"));
+
+    auto started = std::chrono::steady_clock::now();
+
+    auto fail = [&]() {
+        close_pipes();
+        governor_.release(ticket, kind, std::nullopt, units);
+        if (report) progress_->emit(parser.make_event("failed"));
+        return false;
+    };
+
+    // flush before forking so buffered output is not duplicated in the child
+    std::cout.flush();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "[error] fork failed" << std::endl;
+        return fail();
+    }
+
+    if (pid == 0) {
+        if (capture) {
+            dup2(out_pipe[1], STDOUT_FILENO);
+            dup2(err_pipe[1], STDERR_FILENO);
+        }
+        execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    if (capture) {
+        close(out_pipe[1]);
+        close(err_pipe[1]);
+        out_pipe[1] = err_pipe[1] = -1;
+
+        // ffmpeg's stdout is the -progress stream, which is not meant for people.
+        // pump_output closes the read ends once they hit eof
+        bool is_ffmpeg = (kind == JobKind::Render || kind == JobKind::Preview || kind == JobKind::Ladder);
+        pump_output(out_pipe[0], err_pipe[0], !is_ffmpeg, parser);
+        out_pipe[0] = err_pipe[0] = -1;
+    }
+
+    // wait4 gives us the child's own rusage, including whatever it waited on
+    int status = 0;
+    struct rusage usage {};
+    while (wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) return fail();
+    }
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    double cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                 usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+
+    JobUsage measured;
+    measured.peak_rss_mb = usage.ru_maxrss / 1024.0; // linux reports kilobytes
+    measured.cores = (wall > 0.0) ? cpu / wall : 0.0;
+    governor_.release(ticket, kind, measured, units);
+
+    bool success = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (report) progress_->emit(parser.make_event(success ? "done" : "failed"));
+
+    return success;
 }
 
 // --metadata extraction--
@@ -46,7 +234,7 @@ bool ExternalTools::execute_command(const std::string& cmd) {
 std::optional<VideoMetadata> ExternalTools::get_youtube_metadata(const std::string& url) {
     // ask yt-dlp for the full title
     std::stringstream cmd;
-    cmd << "yt-dlp --print \"%(artist)s\" --print \"%(track)s\" --print \"%(title)s\" "
+    cmd << paths_.ytdlp_binary.string() << " --print \"%(artist)s\" --print \"%(track)s\" --print \"%(title)s\" "
         << "\"" << url << "\"";
     
 
@@ -130,12 +318,13 @@ std::optional<fs::path> ExternalTools::download_audio(const std::string& url, co
 
     // clean up wav file for parser
     std::stringstream cmd;
-    cmd << "yt-dlp -x --audio-format wav "
+    cmd << paths_.ytdlp_binary.string() << " -x --audio-format wav "
+        << (reporting() ? "--newline " : "")  // one progress line per update
         << "--postprocessor-args \"ffmpeg:-map_metadata -1 -fflags +bitexact -acodec pcm_s16le -ar 44100 -ac 2\" "
         << "--output \"" << out_path.string() << "\" "
         << "\"" << url << "\"";
 
-    if (execute_command(cmd.str())) {
+    if (execute_command(cmd.str(), JobKind::Download, out_path.filename().string())) {
         if (fs::exists(out_path)) return out_path;
     }
 
@@ -155,7 +344,7 @@ std::optional<fs::path> ExternalTools::run_separator(const fs::path& input_wav,
         << "\"" << out_path.string() << "\"";
     
     
-    if (execute_command(cmd.str())) {
+    if (execute_command(cmd.str(), JobKind::Separator, out_path.filename().string())) {
         if (fs::exists(out_path)) return out_path;
     }
 
@@ -172,7 +361,7 @@ bool ExternalTools::render_video(const fs::path& audio_path,
 
     // ffmpeg command to combine audio + ass subtitles + black background
     std::stringstream cmd;
-    cmd << "ffmpeg -y "
+    cmd << paths_.ffmpeg_binary.string() << " -y " << ffmpeg_progress_args()
         << "-f lavfi -i color=c=black:s=1920x1080:r=30 " // black background
         << "-i \"" << audio_path.string() << "\" "       // audio input
         << "-vf \"ass=" << ass_path.string() << "\" "    // subtitle filter
@@ -180,8 +369,111 @@ bool ExternalTools::render_video(const fs::path& audio_path,
         << "-c:v libx264 -c:a aac -b:a 192k "
         << "\"" << out_path.string() << "\"";
 
-    return execute_command(cmd.str());
+    return execute_command(cmd.str(), JobKind::Render, out_path.filename().string());
+
+}
+
+
+bool ExternalTools::render_ladder(const fs::path& audio_path,
+                                  const std::vector<RenderTarget>& targets) {
+
+    if (targets.empty()) return true;
+
+    for (const auto& target : targets) {
+        fs::create_directories(target.out_path.parent_path());
+    }
+
+    // filter graph: one audio split, plus a background + subtitle chain per target
+    std::stringstream graph;
+    graph << "[0:a]asplit=" << targets.size();
+    for (size_t i = 0; i < targets.size(); ++i) graph << "[a" << i << "]";
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const auto& target = targets[i];
+        graph << ";color=c=black:s=" << target.width << "x" << target.height << ":r=30,"
+              << "ass=" << target.ass_path.string() << "[v" << i << "]";
+    }
+
+    std::stringstream cmd;
+    cmd << paths_.ffmpeg_binary.string() << " -y " << ffmpeg_progress_args()
+        << "-i \"" << audio_path.string() << "\" "
+        << "-filter_complex \"" << graph.str() << "\" ";
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+        cmd << "-map \"[v" << i << "]\" -map \"[a" << i << "]\" "
+            << "-shortest "
+            << "-c:v libx264 -c:a aac -b:a 192k "
+            << "\"" << targets[i].out_path.string() << "\" ";
+    }
+
+    return execute_command(cmd.str(), JobKind::Ladder, targets.front().out_path.filename().string(),
+                           std::nullopt, targets.size());
+}
+
+bool ExternalTools::render_preview(const fs::path& audio_path,
+                                   const fs::path& ass_path,
+                                   const fs::path& out_path,
+                                   const PreviewOptions& options) {
+
+    fs::create_directories(out_path.parent_path());
+
+    double duration = std::max(0.1, options.duration);
+
+    // the background only covers the preview window, so shift its timestamps
+    // into song time for the ass filter and back to zero for the encoder
+    std::stringstream cmd;
+    cmd << paths_.ffmpeg_binary.string() << " -y " << ffmpeg_progress_args()
+        << "-f lavfi -i color=c=black:s=" << options.width << "x" << options.height
+        << ":r=" << options.fps << ":d=" << duration << " "
+        << "-ss " << options.start_time << " -t " << duration << " "   // seek audio input
+        << "-i \"" << audio_path.string() << "\" "
+        << "-vf \"setpts=PTS+" << options.start_time << "/TB,"
+        << "ass=" << ass_path.string() << ",setpts=PTS-STARTPTS\" "
+        << "-shortest "
+        << "-c:v libx264 -preset ultrafast -tune zerolatency -crf 35 "
+        << "-c:a aac -b:a 96k "
+        << "\"" << out_path.string() << "\"";
 
+    return execute_command(cmd.str(), JobKind::Preview, out_path.filename().string(), duration);
 }
 
+bool ExternalTools::render_stream(const fs::path& audio_path,
+                                  const fs::path& ass_path,
+                                  const fs::path& out_path,
+                                  const StreamOptions& options) {
 
+    fs::create_directories(out_path.parent_path());
+
+    double segment = std::max(0.5, options.segment_duration);
+
+    std::stringstream cmd;
+    cmd << paths_.ffmpeg_binary.string() << " -y " << ffmpeg_progress_args()
+        << "-f lavfi -i color=c=black:s=1920x1080:r=30 "
+        << "-i \"" << audio_path.string() << "\" "
+        << "-vf \"ass=" << ass_path.string() << "\" "
+        << "-shortest "
+        << "-c:v libx264 -c:a aac -b:a 192k "
+        // a keyframe at every boundary so each fragment is independently playable
+        << "-force_key_frames \"expr:gte(t,n_forced*" << segment << ")\" "
+        << "-flush_packets 1 ";
+
+    if (options.format == StreamFormat::Hls) {
+        fs::path segment_pattern = out_path.parent_path() / "segment_%05d.m4s";
+
+        cmd << "-f hls -hls_time " << segment << " "
+            << "-hls_list_size 0 -hls_playlist_type event "  // keep every segment, playlist only grows
+            << "-hls_segment_type fmp4 -hls_fmp4_init_filename init.mp4 "
+            << "-hls_flags independent_segments+temp_file "  // segments appear only once complete
+            << "-hls_segment_filename \"" << segment_pattern.string() << "\" ";
+    } else {
+        int fragment_us = static_cast<int>(segment * 1000000);
+
+        cmd << "-movflags +frag_keyframe+empty_moov+default_base_moof "
+            << "-frag_duration " << fragment_us << " "
+            << "-f mp4 ";
+    }
+
+    cmd << "\"" << out_path.string() << "\"";
+
+    return execute_command(cmd.str(), JobKind::Render, out_path.filename().string());
+}
@@ -3,6 +3,9 @@
 #include <vector>
 #include <filesystem>
 #include <optional>
+#include <memory>
+#include "ResourceGovernor.hpp"
+#include "ProgressReporter.hpp"
 
 struct VideoMetadata {
     std::string title;
@@ -11,19 +14,57 @@ struct VideoMetadata {
 
 struct Paths {
         std::filesystem::path separator_binary = "./separator";
+        std::filesystem::path ytdlp_binary = "yt-dlp";   // looked up on PATH
+        std::filesystem::path ffmpeg_binary = "ffmpeg";  // looked up on PATH
         std::filesystem::path temp_dir = "temp";
         std::filesystem::path output_dir = "output";
+        std::filesystem::path artifacts_dir = "artifacts";
+    };
+
+// one rung of a render ladder: its own resolution, subtitles and output file
+struct RenderTarget {
+        std::string name;
+        int width = 1920;
+        int height = 1080;
+        std::filesystem::path ass_path;
+        std::filesystem::path out_path;
+    };
+
+// settings for a quick low-res qa render of part of the song
+struct PreviewOptions {
+        double start_time = 0.0; // seconds into the song
+        double duration = 30.0;  // seconds of video to render
+        int width = 640;
+        int height = 360;
+        int fps = 10;
+    };
+
+// progressive output that is playable while ffmpeg is still encoding
+enum class StreamFormat {
+    FragmentedMp4, // single .mp4 with moof fragments, no trailing moov
+    Hls            // growing event playlist of fmp4 segments
+};
+
+struct StreamOptions {
+        StreamFormat format = StreamFormat::Hls;
+        double segment_duration = 2.0; // seconds per fragment / segment
     };
 
 class ExternalTools {
 public:
     
 
-    ExternalTools(Paths paths = Paths()) : paths_(paths) {
+    ExternalTools(Paths paths = Paths(), GovernorConfig governor = GovernorConfig())
+        : paths_(paths), governor_(governor) {
         std::filesystem::create_directories(paths_.temp_dir);
         std::filesystem::create_directories(paths_.output_dir);
     }
 
+    const Paths& paths() const { return paths_; }
+
+    // children report structured progress through this reporter when it is enabled
+    void set_progress_reporter(std::shared_ptr<ProgressReporter> reporter) { progress_ = std::move(reporter); }
+
     // 1. get title/artist from youtube url
     std::optional<VideoMetadata> get_youtube_metadata(const std::string& url);
 
@@ -41,10 +82,44 @@ public:
                       const std::filesystem::path& ass_path, 
                       const std::filesystem::path& out_path);
 
+    // 4b. render several targets in one ffmpeg run; the audio is decoded once
+    //     and split across the outputs
+    bool render_ladder(const std::filesystem::path& audio_path,
+                       const std::vector<RenderTarget>& targets);
+
+    // 5. render a short low-res preview with the fastest encoder settings
+    bool render_preview(const std::filesystem::path& audio_path,
+                        const std::filesystem::path& ass_path,
+                        const std::filesystem::path& out_path,
+                        const PreviewOptions& options = PreviewOptions());
+
+    // 6. render as a stream; out_path is the .mp4 (fragmented mp4)
+    //    or the playlist .m3u8 (hls, segments are written next to it)
+    bool render_stream(const std::filesystem::path& audio_path,
+                       const std::filesystem::path& ass_path,
+                       const std::filesystem::path& out_path,
+                       const StreamOptions& options = StreamOptions());
+
 private:
     Paths paths_;
+    ResourceGovernor governor_;
+    std::shared_ptr<ProgressReporter> progress_;
+
+    bool reporting() const { return progress_ && progress_->enabled(); }
+
+    // extra ffmpeg arguments for the -progress key/value stream
+    std::string ffmpeg_progress_args() const;
+
+    // runs cmd through the shell once the governor admits it, and reports
+    // the child's peak rss and cpu use back so later estimates improve.
+    // while reporting, child output is parsed into progress events for label.
+    // units is the number of outputs the child writes, see ResourceGovernor::acquire
+    bool execute_command(const std::string& cmd, JobKind kind, const std::string& label,
+                         std::optional<double> duration_hint = std::nullopt, size_t units = 1);
 
-    bool execute_command(const std::string& cmd);
+    // echoes child output and feeds it line by line to the parser until both pipes close.
+    // always closes both fds before returning
+    void pump_output(int out_fd, int err_fd, bool echo_stdout, ProgressParser& parser);
 
     std::string run_command_with_output(const std::string& cmd);
 
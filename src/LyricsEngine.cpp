@@ -1,4 +1,5 @@
 #include "LyricsEngine.hpp"
+#include "SubtitleLayouts.hpp"
 #include <iostream>
 #include <curl/curl.h>
 #include <sstream>
@@ -70,9 +71,9 @@ std::string LyricsFetcher::perform_get_request(const std::string& url) {
 
 std::optional<std::string> LyricsFetcher::fetch_lyrics(const std::string& artist, const std::string& title) {
     // contruct the api url
-    // endpoint https://lrclib.net/api/get?artist_name=...&track_name=...
+    // endpoint <base_url>/api/get?artist_name=...&track_name=...
 
-    std::string query_url = "https://lrclib.net/api/get?artist_name=" + url_encode(artist) +
+    std::string query_url = base_url_ + "/api/get?artist_name=" + url_encode(artist) +
                             "&track_name=" + url_encode(title);
     
     std::cout << "[network] fetching lyrics from: " << query_url << std::endl;
@@ -225,7 +226,21 @@ std::vector<LyricLine> AssConverter::parse_lrc(const std::string& lrc_content) {
 
 }
 
-std::string AssConverter::generate_header() {
+AssConfig AssConverter::scaled_config(const AssConfig& base, int resolution_x, int resolution_y) {
+    AssConfig config = base;
+
+    double scale = std::min(resolution_x, resolution_y) / 1080.0;
+
+    config.resolution_x = resolution_x;
+    config.resolution_y = resolution_y;
+    config.font_size_current = static_cast<int>(std::lround(base.font_size_current * scale));
+    config.font_size_next = static_cast<int>(std::lround(base.font_size_next * scale));
+    config.font_size_next2 = static_cast<int>(std::lround(base.font_size_next2 * scale));
+
+    return config;
+}
+
+std::string AssConverter::generate_header(const std::string& styles) {
     std::stringstream ss;
     ss << "[Script Info]\n"
        << "Title: Karaoke++ Subtitles\n"
@@ -239,44 +254,26 @@ std::string AssConverter::generate_header() {
        << "Format: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, BackColour, "
        << "Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, Outline, "
        << "Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\n"
-       // current line style (white, larger)
-       << "Style: KaraokeCurrent," << config_.font_name << "," << config_.font_size_current 
-       << ",&H00FFFFFF,&H00FFFFFF,&H00000000,&H00000000,-1,0,0,0,100,100,0,0,1,3,3,2,10,10,10,1\n"
-       // next line style (faded white)
-       << "Style: KaraokeNext," << config_.font_name << "," << config_.font_size_next 
-       << ",&H88FFFFFF,&H00FFFFFF,&H00000000,&H00000000,0,0,0,0,100,100,0,0,1,2,2,2,10,10,10,1\n"
-       // next2 line style (more faded)
-       << "Style: KaraokeNext2," << config_.font_name << "," << config_.font_size_next2
-       << ",&H66FFFFFF,&H00FFFFFF,&H00000000,&H00000000,0,0,0,0,100,100,0,0,1,1,1,2,10,10,10,1\n\n"
+       << styles << "\n"
        << "[Events]\n"
        << "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n";
     return ss.str();
 }
 
-std::string AssConverter::generate_karaoke_text(const LyricLine& line) {
-    if (!line.is_word_level) return line.text;
-
-    std::stringstream ss;
-
-    for (const auto& word : line.words) {
-        // duration in centiseconds
-
-        int duration_cs = static_cast<int> ((word.end_time - word.start_time) * 100);
-        ss << "{\\k}" << duration_cs << "}" << word.text;
-    }
-
-    return ss.str();
-
-}
-
-std::string AssConverter::generate_ass(const std::vector<LyricLine>& lines) {
+template <typename Layout>
+std::string AssConverter::generate_with(const Layout& layout, const std::vector<LyricLine>& lines) {
     std::stringstream ss;
-    ss << generate_header();
+    ss << generate_header(layout.styles());
 
     double trans_dur = config_.transition_duration;
 
     int trans_ms = static_cast<int>(trans_dur * 1000);
 
+    // preview text is needed up to three times per line, so build it once
+    std::vector<std::string> plain_text;
+    plain_text.reserve(lines.size());
+    for (const auto& line : lines) plain_text.push_back(line_plain_text(line));
+
     for (size_t i = 0; i < lines.size(); ++i) {
         const auto& line = lines[i];
 
@@ -293,51 +290,28 @@ std::string AssConverter::generate_ass(const std::vector<LyricLine>& lines) {
         std::string start_ts = format_time_ass(line.start_time);
         std::string end_ts = format_time_ass(line.end_time);
 
-        // 1. current line event
-
-        std::string text_content = generate_karaoke_text(line);
-
-        // {\move(x1,y1,x2,y2,t1,t2)\fad(t1,t2)}
-        ss << "Dialogue: 0," << start_ts << "," << end_ts << ",KaraokeCurrent,,0,0,0,,"
-           << "{\\move(960,520,960,400," << move_start_ms << "," << dur_ms << ")"
-           << "\\fad(0," << effective_trans_ms << ")}" 
-           << text_content << "\n";
-
-        // 2. next line event (preview)
-        if (i + 1 < lines.size()) {
-            std::string next_text = lines[i+1].is_word_level ? 
-                                    [&](){ 
-                                        std::string s; 
-                                        for(auto& w : lines[i+1].words) s += w.text; 
-                                        return s; 
-                                    }() 
-                                    : lines[i+1].text;
-
-            ss << "Dialogue: 0," << start_ts << "," << end_ts << ",KaraokeNext,,0,0,0,,"
-               << "{\\move(960,660,960,520," << move_start_ms << "," << dur_ms << ")}"
-               << next_text << "\n";
-        }
-
-        // 3. next2 line event (preview)
-        if (i + 2 < lines.size()) {
-            std::string next2_text = lines[i+2].is_word_level ? 
-                                     [&](){ 
-                                        std::string s; 
-                                        for(auto& w : lines[i+2].words) s += w.text; 
-                                        return s; 
-                                    }() 
-                                     : lines[i+2].text;
-
-            ss << "Dialogue: 0," << start_ts << "," << end_ts << ",KaraokeNext2,,0,0,0,,"
-               << "{\\move(960,800,960,660," << move_start_ms << "," << dur_ms << ")"
-               << "\\fad(" << effective_trans_ms << ",0)}"
-               << next2_text << "\n";
-        }
+        EmitContext ctx{lines, plain_text, i, start_ts, end_ts, dur_ms, move_start_ms, effective_trans_ms};
+        layout.emit(ss, ctx);
     }
 
     return ss.str();
 }
 
+std::string AssConverter::generate_ass(const std::vector<LyricLine>& lines) {
+    // the only layout branch: pick the specialised emit loop once
+    switch (config_.layout) {
+        case SubtitleLayout::Duet:
+            return generate_with(DuetLayout(config_), lines);
+        case SubtitleLayout::Vertical:
+            return generate_with(VerticalLayout(config_), lines);
+        case SubtitleLayout::WordHighlight:
+            return generate_with(WordHighlightLayout(config_), lines);
+        case SubtitleLayout::ClassicScroll:
+            break;
+    }
+    return generate_with(ClassicScrollLayout(config_), lines);
+}
+
 
 void AssConverter::save_to_file(const std::string& content, const std::filesystem::path& path) {
 
@@ -4,6 +4,7 @@
 #include <vector>
 #include <optional>
 #include <filesystem>
+#include <utility>
 #include <nlohmann/json.hpp>
 
 // data structures
@@ -26,10 +27,15 @@ struct LyricLine {
 
 class LyricsFetcher {
 public:
+    // base_url points at an lrclib compatible server
+    LyricsFetcher(std::string base_url = "https://lrclib.net") : base_url_(std::move(base_url)) {}
+
     // fetches raw LRC string from LRCLIB
     std::optional<std::string> fetch_lyrics(const std::string& artist, const std::string& title);
 
 private:
+    std::string base_url_;
+
     // lib curl helper functions
     static size_t WriteCallBack(void* contents, size_t size, size_t nmemb, std::string* userp);
     std::string url_encode(const std::string& value);
@@ -37,6 +43,14 @@ private:
 
 };
 
+// which subtitle layout generate_ass emits (see SubtitleLayouts.hpp)
+enum class SubtitleLayout {
+    ClassicScroll,  // current line plus two scrolling previews
+    Duet,           // two lines alternating between top and bottom slots
+    Vertical,       // classic scroll tuned for 9:16 frames
+    WordHighlight   // single line, words fill as they are sung
+};
+
 struct AssConfig {
         int resolution_x = 1920;
         int resolution_y = 1080;
@@ -45,6 +59,7 @@ struct AssConfig {
         int font_size_next = 60;
         int font_size_next2 = 60;
         double transition_duration = 0.3;
+        SubtitleLayout layout = SubtitleLayout::ClassicScroll;
     };
 
 
@@ -53,6 +68,12 @@ public:
     
     AssConverter(AssConfig config = AssConfig()) : config_(config) {}
 
+    const AssConfig& config() const { return config_; }
+
+    // copy of base retargeted to another resolution; font sizes follow the
+    // short side so a 1080x1920 vertical cut keeps the 1080p text size
+    static AssConfig scaled_config(const AssConfig& base, int resolution_x, int resolution_y);
+
     // parses raw lrc string into structed data
     std::vector<LyricLine> parse_lrc(const std::string& lrc_content);
 
@@ -66,8 +87,11 @@ private:
 
     std::string format_time_ass(double seconds);
     double parse_time_lrc(const std::string& timestamp);
-    std::string generate_header();
-    std::string generate_karaoke_text(const LyricLine& line);
+    std::string generate_header(const std::string& styles);
+
+    // emit loop specialised per layout policy type
+    template <typename Layout>
+    std::string generate_with(const Layout& layout, const std::vector<LyricLine>& lines);
 
 };
 
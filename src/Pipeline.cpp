@@ -0,0 +1,259 @@
+#include "Pipeline.hpp"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+std::string sanitize_filename(std::string name) {
+    std::string invalid_chars = "\\/:?\"<>|";
+    for (char& c : name) {
+        if (invalid_chars.find(c) != std::string::npos) {
+            c = '_';
+        }
+    }
+
+    return name;
+}
+
+PreviewOptions preview_for_lines(const std::vector<LyricLine>& lines, size_t n) {
+    PreviewOptions options;
+    if (lines.empty() || n == 0) return options;
+
+    size_t last = std::min(n, lines.size()) - 1;
+    options.start_time = lines[0].start_time;
+    options.duration = lines[last].end_time - lines[0].start_time;
+    return options;
+}
+
+PipelineResult run_pipeline(std::string input,
+                            const PipelineOptions& options,
+                            ExternalTools& tools,
+                            LyricsFetcher& lyrics_fetcher,
+                            AssConverter& ass_converter) {
+
+    PipelineResult result;
+
+    // stage timing: each finish_stage call closes the stage that started
+    // at the previous call
+    using clock = std::chrono::steady_clock;
+    auto pipeline_start = clock::now();
+    auto stage_start = pipeline_start;
+
+    auto finish_stage = [&](const std::string& stage) {
+        auto now = clock::now();
+        result.stages.push_back({stage, std::chrono::duration<double>(now - stage_start).count()});
+        stage_start = now;
+    };
+
+    auto finish = [&](bool success) {
+        result.success = success;
+        result.total_seconds = std::chrono::duration<double>(clock::now() - pipeline_start).count();
+        return result;
+    };
+
+    // if input doesnt look like a url, treat it as a search
+    if (input.find("http") == std::string::npos) {
+        input = "ytsearch1:\"" + input + "\"";
+    }
+
+    const Paths& paths = tools.paths();
+
+    // create hash of input string to use as folder name
+    size_t input_hash = std::hash<std::string>{}(input);
+    result.project_id = std::to_string(input_hash);
+
+    fs::path project_dir = paths.artifacts_dir / result.project_id;
+    fs::create_directories(project_dir);
+
+    fs::path p_source_wav =       project_dir / "source.wav";
+    fs::path p_instrumental_wav = project_dir / "instrumental.wav";
+    fs::path p_subtitles_ass =    project_dir / "karaoke.ass";
+
+    std::cout << "project id: " << result.project_id << std::endl;
+    std::cout << "artificats: " << project_dir << std::endl;
+
+
+    // 1. get metadata
+    std::cout << "\n [1/5] fetching metadata..." << std::endl;
+
+    auto metadata_opt = tools.get_youtube_metadata(input);
+    if (!metadata_opt) {
+        std::cerr << "failed to get metadata" << std::endl;
+        return finish(false);
+    }
+
+    VideoMetadata meta = *metadata_opt;
+
+    std::cout << "  title:  " << meta.title << std::endl;
+    std::cout << "  artist  " << meta.artist << std::endl;
+
+    if (meta.artist.empty()) {
+        std::cout << "artist detection failed. using title as query.." << std::endl;
+    }
+    finish_stage("metadata");
+
+    // 2. download audio
+    std::cout << "\n[2/5] downloading audio..." << std::endl;
+    auto audio_path = tools.download_audio(input, p_source_wav);
+    if (!audio_path) return finish(false);
+    finish_stage("download");
+
+    // preview mode: render a quick qa clip against the original audio
+    // and stop before paying for separation and the full render
+    if (options.preview) {
+        std::cout << "\n[preview] fetching lyrics..." << std::endl;
+
+        auto lrc_opt = lyrics_fetcher.fetch_lyrics(meta.artist, meta.title);
+        if (!lrc_opt && meta.artist.empty()) {
+            lrc_opt = lyrics_fetcher.fetch_lyrics("", meta.title);
+        }
+        if (!lrc_opt) {
+            std::cerr << "lyrics not found. nothing to preview" << std::endl;
+            return finish(false);
+        }
+        finish_stage("lyrics");
+
+        auto lines = ass_converter.parse_lrc(*lrc_opt);
+        ass_converter.save_to_file(ass_converter.generate_ass(lines), p_subtitles_ass);
+        finish_stage("subtitles");
+
+        PreviewOptions preview_options = options.preview_options;
+        if (options.preview_lines > 0) {
+            PreviewOptions window = preview_for_lines(lines, options.preview_lines);
+            preview_options.start_time = window.start_time;
+            preview_options.duration = window.duration;
+        }
+
+        fs::path out_preview = project_dir / "preview.mp4";
+        std::cout << "rendering preview (" << preview_options.start_time << "s + "
+                  << preview_options.duration << "s)..." << std::endl;
+
+        if (!tools.render_preview(*audio_path, p_subtitles_ass, out_preview, preview_options)) {
+            std::cerr << "preview render failed" << std::endl;
+            return finish(false);
+        }
+        finish_stage("preview");
+
+        std::cout << "preview: " << out_preview << std::endl;
+        return finish(true);
+    }
+
+    // 3. separate audio
+
+    std::cout << "\n[3/5] separating vocals..." << std::endl;
+    auto final_audio_path = *audio_path;
+
+    // check if separator binary exists
+    if (fs::exists(paths.separator_binary)) {
+        auto separated_path = tools.run_separator(*audio_path, p_instrumental_wav);
+        if (separated_path) {
+            final_audio_path = *separated_path;
+            std::cout << " separation complete" << std::endl;
+        } else {
+            std::cerr << " separation failed. using original audio" << std::endl;
+        }
+    } else {
+        std::cerr << " separator binary not found, using original audio" << std::endl;
+    }
+    finish_stage("separation");
+
+    // fetch and process lyrics
+
+    std::cout << "\n[4/5] fetching lyrics..." << std::endl;
+
+    auto lrc_opt = lyrics_fetcher.fetch_lyrics(meta.artist, meta.title);
+
+    if (!lrc_opt && meta.artist.empty()) {
+        // try fetching with just title if artist is empty
+        lrc_opt = lyrics_fetcher.fetch_lyrics("", meta.title);
+    }
+
+    if (!lrc_opt) {
+        std::cerr << "lyrics not found. proceeding with instrumental video" << std::endl;
+        lrc_opt = "[00:00.00] (Instrumental / Lyrics not found)";
+    }
+    finish_stage("lyrics");
+
+    std::cout << " parsing lyrics..." << std::endl;
+
+    auto lines = ass_converter.parse_lrc(*lrc_opt);
+
+    std::string ass_content = ass_converter.generate_ass(lines);
+    ass_converter.save_to_file(ass_content, p_subtitles_ass);
+
+    // 5. render videos
+    std::string safe_title = sanitize_filename(meta.title);
+    if (!meta.artist.empty()) safe_title = sanitize_filename(meta.artist) + " - " + safe_title;
+
+    fs::path output_dir = paths.output_dir;
+    fs::create_directories(output_dir);
+
+    // render ladder: every rung gets subtitles laid out for its own resolution
+    struct LadderRung { std::string name; int width; int height; };
+    const std::vector<LadderRung> rungs = {
+        {"1080p", 1920, 1080},
+        {"720p", 1280, 720},
+        {"vertical", 1080, 1920},
+    };
+
+    std::vector<RenderTarget> ladder_targets;
+    if (options.ladder) {
+        for (const auto& rung : rungs) {
+            RenderTarget target;
+            target.name = rung.name;
+            target.width = rung.width;
+            target.height = rung.height;
+            target.ass_path = project_dir / ("karaoke_" + rung.name + ".ass");
+
+            AssConfig rung_config = AssConverter::scaled_config(ass_converter.config(), rung.width, rung.height);
+
+            // portrait frames get the scroll tuned for 9:16
+            if (rung.height > rung.width && rung_config.layout == SubtitleLayout::ClassicScroll) {
+                rung_config.layout = SubtitleLayout::Vertical;
+            }
+
+            AssConverter rung_converter(rung_config);
+            rung_converter.save_to_file(rung_converter.generate_ass(lines), target.ass_path);
+
+            ladder_targets.push_back(target);
+        }
+    }
+    finish_stage("subtitles");
+
+    // renders a regular mp4, the ladder, or a progressive stream that can
+    // be played while encoding is still running
+    const auto& stream_options = options.stream_options;
+    auto render = [&](const fs::path& audio, const std::string& name) {
+        if (options.ladder) {
+            std::vector<RenderTarget> targets = ladder_targets;
+            for (auto& target : targets) {
+                target.out_path = output_dir / (name + " [" + target.name + "].mp4");
+            }
+            return tools.render_ladder(audio, targets);
+        }
+
+        if (!stream_options) {
+            return tools.render_video(audio, p_subtitles_ass, output_dir / (name + ".mp4"));
+        }
+
+        fs::path out_path = output_dir / (name + ".mp4");
+        if (stream_options->format == StreamFormat::Hls) {
+            out_path = output_dir / name / "index.m3u8";
+        }
+        std::cout << "streaming to: " << out_path << std::endl;
+        return tools.render_stream(audio, p_subtitles_ass, out_path, *stream_options);
+    };
+
+    // video 1: instrumental
+    std::cout << "rendering instrumental video..." << std::endl;
+    bool rendered = render(final_audio_path, safe_title + " (instrumental)");
+
+    // video 2 : original audio
+    std::cout << "rendering original video..." << std::endl;
+    rendered = render(p_source_wav, safe_title + " (original)") && rendered;
+    finish_stage("render");
+
+    return finish(rendered);
+}
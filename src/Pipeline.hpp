@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include "ExternalTools.hpp"
+#include "LyricsEngine.hpp"
+
+// what the pipeline should produce for one input
+struct PipelineOptions {
+        bool preview = false;
+        size_t preview_lines = 0; // > 0 overrides the preview window with the first n lines
+        PreviewOptions preview_options;
+        std::optional<StreamOptions> stream_options;
+        bool ladder = false;
+    };
+
+struct StageTiming {
+    std::string stage;
+    double seconds = 0.0;
+};
+
+struct PipelineResult {
+    bool success = false;
+    std::string project_id;
+    std::vector<StageTiming> stages; // in execution order
+    double total_seconds = 0.0;
+};
+
+std::string sanitize_filename(std::string name);
+
+// picks the preview window covering the first n lyric lines
+PreviewOptions preview_for_lines(const std::vector<LyricLine>& lines, size_t n);
+
+// runs metadata -> download -> separation -> lyrics -> subtitles -> render
+// for a youtube url or search term, timing every stage
+PipelineResult run_pipeline(std::string input,
+                            const PipelineOptions& options,
+                            ExternalTools& tools,
+                            LyricsFetcher& lyrics_fetcher,
+                            AssConverter& ass_converter);
@@ -0,0 +1,353 @@
+#include "ProgressReporter.hpp"
+#include <iostream>
+#include <sstream>
+#include <regex>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+
+// "01:02:03", "02:03" or "03" -> seconds
+std::optional<double> parse_clock(const std::string& text) {
+    std::stringstream ss(text);
+    std::string part;
+    double seconds = 0.0;
+    bool any = false;
+
+    while (std::getline(ss, part, ':')) {
+        try {
+            seconds = seconds * 60.0 + std::stod(part);
+            any = true;
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+
+    if (!any) return std::nullopt;
+    return seconds;
+}
+
+// "KiB" -> 1024 etc, for yt-dlp transfer rates
+double unit_bytes(const std::string& unit) {
+    if (unit == "KiB") return 1024.0;
+    if (unit == "MiB") return 1024.0 * 1024.0;
+    if (unit == "GiB") return 1024.0 * 1024.0 * 1024.0;
+    if (unit == "KB" || unit == "kB") return 1000.0;
+    if (unit == "MB") return 1000.0 * 1000.0;
+    if (unit == "GB") return 1000.0 * 1000.0 * 1000.0;
+    return 1.0;
+}
+
+// no more than four updates a second; a heartbeat at least every two
+constexpr double throttle_seconds = 0.25;
+constexpr double heartbeat_seconds = 2.0;
+
+double seconds_since(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// write() to a pipe whose reader is gone raises SIGPIPE. block it for this
+// thread only and swallow the pending signal, so the process-wide
+// disposition that exec'd children inherit stays untouched
+ssize_t write_no_sigpipe(int fd, const char* data, size_t size) {
+    sigset_t sigpipe, old_mask;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &old_mask);
+
+    ssize_t n = write(fd, data, size);
+    int saved_errno = errno;
+
+    if (n < 0 && saved_errno == EPIPE && !sigismember(&old_mask, SIGPIPE)) {
+        timespec no_wait {};
+        sigtimedwait(&sigpipe, nullptr, &no_wait);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    errno = saved_errno;
+    return n;
+}
+
+}
+
+// --reporter--
+
+ProgressReporter::~ProgressReporter() {
+    if (owns_fd_ && fd_ >= 0) close(fd_);
+}
+
+bool ProgressReporter::open_fd(int fd) {
+    // stdin/stdout/stderr carry logs and child output, and children need them
+    if (fd <= STDERR_FILENO) return false;
+
+    // the descriptor is ours to write to; children must not inherit it
+    int flags = fcntl(fd, F_GETFD);
+    if (flags < 0) return false;
+    fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = fd;
+    owns_fd_ = false;
+    is_socket_ = false;
+    return true;
+}
+
+bool ProgressReporter::open_socket(const std::filesystem::path& socket_path) {
+    // cloexec so children never inherit the connection
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::string path = socket_path.string();
+    if (path.size() >= sizeof(addr.sun_path)) {
+        close(fd);
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "[progress] failed to connect to " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = fd;
+    owns_fd_ = true;
+    is_socket_ = true;
+    return true;
+}
+
+void ProgressReporter::emit(const ProgressEvent& event) {
+    json j = {{"stage", event.stage},
+              {"status", event.status},
+              {"elapsed", event.elapsed_seconds}};
+
+    if (!event.label.empty()) j["label"] = event.label;
+    if (event.percent) j["percent"] = *event.percent;
+    if (event.speed) {
+        j["speed"] = *event.speed;
+        j["speed_unit"] = event.speed_unit;
+    }
+    if (event.eta_seconds) j["eta"] = *event.eta_seconds;
+
+    std::string line = j.dump() + "\n";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) return;
+
+    size_t sent = 0;
+    while (sent < line.size()) {
+        ssize_t n = is_socket_ ? send(fd_, line.data() + sent, line.size() - sent, MSG_NOSIGNAL)
+                               : write_no_sigpipe(fd_, line.data() + sent, line.size() - sent);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            // the consumer went away; stop reporting rather than failing the job
+            std::cerr << "[progress] write failed, disabling progress events" << std::endl;
+            if (owns_fd_) close(fd_);
+            fd_ = -1;
+            return;
+        }
+        sent += n;
+    }
+}
+
+// --parser--
+
+ProgressParser::ProgressParser(JobKind kind, std::string label, std::optional<double> duration_hint)
+    : kind_(kind), label_(std::move(label)), duration_(duration_hint),
+      started_(clock_type::now()), last_emit_(started_) {}
+
+ProgressEvent ProgressParser::make_event(const std::string& status) const {
+    ProgressEvent event;
+    event.stage = job_kind_name(kind_);
+    event.status = status;
+    event.label = label_;
+    event.percent = percent_;
+    event.speed = speed_;
+    event.speed_unit = speed_unit_;
+    event.eta_seconds = eta_;
+    event.elapsed_seconds = seconds_since(started_);
+
+    if (status == "done") {
+        event.percent = 100.0;
+        event.eta_seconds = 0.0;
+    }
+    return event;
+}
+
+std::optional<ProgressEvent> ProgressParser::feed(const std::string& line) {
+    bool changed = false;
+
+    switch (kind_) {
+        case JobKind::Download:  changed = parse_ytdlp(line); break;
+        case JobKind::Separator: changed = parse_separator(line); break;
+        case JobKind::Render:
+        case JobKind::Preview:
+        case JobKind::Ladder:    changed = parse_ffmpeg(line); break;
+    }
+
+    if (!changed) return std::nullopt;
+    return throttled();
+}
+
+std::optional<ProgressEvent> ProgressParser::heartbeat() {
+    // a change held back by the throttle goes out as soon as its window ends
+    if (pending_ && seconds_since(last_emit_) >= throttle_seconds) {
+        pending_ = false;
+        last_emit_ = clock_type::now();
+        return make_event("progress");
+    }
+
+    if (seconds_since(last_emit_) < heartbeat_seconds) return std::nullopt;
+
+    last_emit_ = clock_type::now();
+    return make_event("progress");
+}
+
+int ProgressParser::next_wakeup_ms() const {
+    double wait = (pending_ ? throttle_seconds : heartbeat_seconds) - seconds_since(last_emit_);
+    return std::clamp(static_cast<int>(std::ceil(wait * 1000.0)), 0, 1000);
+}
+
+// at most four updates a second, but never drop the first or final one.
+// updates inside the window are deferred to heartbeat(), not lost
+std::optional<ProgressEvent> ProgressParser::throttled() {
+    bool finished = percent_ && *percent_ >= 100.0;
+    if (reported_ && !finished && seconds_since(last_emit_) < throttle_seconds) {
+        pending_ = true;
+        return std::nullopt;
+    }
+
+    reported_ = true;
+    pending_ = false;
+    last_emit_ = clock_type::now();
+    return make_event("progress");
+}
+
+// [download]  45.3% of ~  3.45MiB at    1.23MiB/s ETA 00:02 (frag 1/5)
+bool ProgressParser::parse_ytdlp(const std::string& line) {
+    static const std::regex download_regex(
+        R"(\[download\]\s+([\d.]+)%(?:.*?\s+at\s+([\d.]+)\s*([A-Za-z]+)/s)?(?:.*?ETA\s+([\d:]+))?)");
+
+    std::smatch match;
+    if (!std::regex_search(line, match, download_regex)) return false;
+
+    percent_ = std::stod(match[1].str());
+
+    if (match[2].matched) {
+        speed_ = std::stod(match[2].str()) * unit_bytes(match[3].str());
+        speed_unit_ = "B/s";
+    }
+    if (match[4].matched) {
+        eta_ = parse_clock(match[4].str());
+    }
+
+    return true;
+}
+
+// the separator only reports phases, so map them onto coarse milestones
+// and take any explicit percentage it prints
+bool ProgressParser::parse_separator(const std::string& line) {
+    static const std::regex percent_regex(R"((\d+(?:\.\d+)?)\s*%)");
+
+    std::optional<double> percent;
+    bool explicit_percent = false;
+
+    std::smatch match;
+    if (std::regex_search(line, match, percent_regex)) {
+        percent = std::stod(match[1].str());
+        explicit_percent = true;
+    } else if (line.find("done!") != std::string::npos) {
+        percent = 100.0;
+    } else if (line.find("inference") != std::string::npos) {
+        percent = 10.0;
+    } else if (line.find("model loaded") != std::string::npos) {
+        percent = 5.0;
+    } else if (line.find("loading") != std::string::npos) {
+        percent = 1.0;
+    }
+
+    if (!percent) return false;
+
+    percent_ = std::min(100.0, *percent);
+
+    // linear extrapolation, only meaningful for real percentages
+    double elapsed = seconds_since(started_);
+    if (explicit_percent && *percent_ > 0.0 && *percent_ < 100.0) {
+        eta_ = elapsed * (100.0 - *percent_) / *percent_;
+    }
+
+    return true;
+}
+
+// ffmpeg -progress key=value stream on stdout, plus the log on stderr
+// for the input duration. stdout may be read first, so progress seen before
+// the duration is kept and applied once the duration arrives
+bool ProgressParser::parse_ffmpeg(const std::string& line) {
+    static const std::regex duration_regex(R"(Duration:\s*(\d+:\d+:[\d.]+))");
+
+    if (!duration_) {
+        std::smatch match;
+        if (std::regex_search(line, match, duration_regex)) {
+            duration_ = parse_clock(match[1].str());
+            return update_ffmpeg_percent();
+        }
+    }
+
+    size_t eq = line.find('=');
+    if (eq == std::string::npos) return false;
+
+    std::string key = line.substr(0, eq);
+    std::string value = line.substr(eq + 1);
+
+    if (key == "speed") {
+        // "1.52x" or "N/A"
+        try {
+            speed_ = std::stod(value);
+            speed_unit_ = "x";
+        } catch (...) {}
+        return false;
+    }
+
+    if (key == "out_time_us") {
+        try {
+            out_time_ = std::stod(value) / 1e6;
+        } catch (...) {
+            return false;
+        }
+        return update_ffmpeg_percent();
+    }
+
+    if (key == "progress" && value == "end") {
+        percent_ = 100.0;
+        eta_ = 0.0;
+        return true;
+    }
+
+    return false;
+}
+
+bool ProgressParser::update_ffmpeg_percent() {
+    if (!duration_ || !out_time_ || *duration_ <= 0.0) return false;
+    // never walk back from a "progress=end" that arrived first
+    if (percent_ && *percent_ >= 100.0) return false;
+
+    percent_ = std::clamp(*out_time_ / *duration_ * 100.0, 0.0, 100.0);
+    if (speed_ && *speed_ > 0.0) {
+        eta_ = std::max(0.0, *duration_ - *out_time_) / *speed_;
+    }
+    return true;
+}
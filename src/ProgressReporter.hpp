@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <optional>
+#include <mutex>
+#include <chrono>
+#include <filesystem>
+#include "ResourceGovernor.hpp"
+
+// one normalized progress update for a child process
+struct ProgressEvent {
+    std::string stage;                  // download, separator, render, preview, ladder
+    std::string status;                 // queued, start, progress, done, failed
+    std::string label;                  // which file the job produces
+    std::optional<double> percent;      // 0 - 100
+    std::optional<double> speed;        // see speed_unit
+    std::string speed_unit;             // "B/s" for downloads, "x" (realtime) for ffmpeg
+    std::optional<double> eta_seconds;
+    double elapsed_seconds = 0.0;
+};
+
+// writes progress events as newline-delimited json to a file descriptor
+// or a unix domain socket. disabled until one of the open_* calls succeeds.
+// safe to share between threads.
+class ProgressReporter {
+public:
+    ProgressReporter() = default;
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    // write to an already open descriptor (not closed by the reporter).
+    // fds 0-2 are refused, and the descriptor is marked close-on-exec
+    bool open_fd(int fd);
+
+    // connect to a listening unix stream socket
+    bool open_socket(const std::filesystem::path& socket_path);
+
+    bool enabled() const { return fd_ >= 0; }
+
+    void emit(const ProgressEvent& event);
+
+private:
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    bool is_socket_ = false;
+    std::mutex mutex_;
+};
+
+// turns the output of one child process into progress events.
+// feed it every line the child prints on stdout or stderr
+class ProgressParser {
+public:
+    // duration_hint is the expected media length for ffmpeg jobs; without it
+    // the parser picks up the input duration from ffmpeg's log
+    ProgressParser(JobKind kind, std::string label, std::optional<double> duration_hint = std::nullopt);
+
+    // returns an event when the line changed the known progress enough to report
+    std::optional<ProgressEvent> feed(const std::string& line);
+
+    // call whenever the child is quiet: sends a change the throttle held
+    // back, or a periodic liveness update carrying the last known progress
+    std::optional<ProgressEvent> heartbeat();
+
+    // how long the caller may wait before heartbeat() has something to send
+    int next_wakeup_ms() const;
+
+    // a start / done / failed event for this job
+    ProgressEvent make_event(const std::string& status) const;
+
+private:
+    JobKind kind_;
+    std::string label_;
+    std::optional<double> duration_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point last_emit_;
+    bool reported_ = false;
+    bool pending_ = false;              // a throttled change not yet sent
+
+    std::optional<double> percent_;
+    std::optional<double> speed_;
+    std::string speed_unit_;
+    std::optional<double> eta_;
+    std::optional<double> out_time_;    // ffmpeg, seconds encoded so far
+
+    bool parse_ytdlp(const std::string& line);
+    bool parse_separator(const std::string& line);
+    bool parse_ffmpeg(const std::string& line);
+    bool update_ffmpeg_percent();
+
+    std::optional<ProgressEvent> throttled();
+};
@@ -0,0 +1,277 @@
+#include "ResourceGovernor.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+// helper : exclusive flock held for the lifetime of the object
+
+struct FileLock {
+    int fd = -1;
+
+    explicit FileLock(const fs::path& path) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd >= 0) flock(fd, LOCK_EX);
+    }
+
+    ~FileLock() {
+        if (fd >= 0) {
+            flock(fd, LOCK_UN);
+            close(fd);
+        }
+    }
+};
+
+// default costs used until a kind has been measured at least once
+
+JobUsage default_usage(JobKind kind) {
+    switch (kind) {
+        case JobKind::Download:  return {256.0, 1.0};
+        case JobKind::Separator: return {3072.0, 4.0};
+        case JobKind::Render:    return {1024.0, 2.0};
+        case JobKind::Preview:   return {512.0, 1.0};
+        case JobKind::Ladder:    return {1024.0, 2.0}; // per target
+    }
+    return {512.0, 1.0};
+}
+
+size_t physical_memory_mb() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    size_t value_kb = 0;
+
+    while (meminfo >> key >> value_kb) {
+        if (key == "MemTotal:") return value_kb / 1024;
+        meminfo.ignore(256, '\n');
+    }
+
+    return 4096;
+}
+
+bool process_alive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+}
+
+const char* job_kind_name(JobKind kind) {
+    switch (kind) {
+        case JobKind::Download:  return "download";
+        case JobKind::Separator: return "separator";
+        case JobKind::Render:    return "render";
+        case JobKind::Preview:   return "preview";
+        case JobKind::Ladder:    return "ladder";
+    }
+    return "unknown";
+}
+
+ResourceGovernor::ResourceGovernor(GovernorConfig config) : config_(config) {
+    if (config_.memory_budget_mb == 0) {
+        config_.memory_budget_mb = physical_memory_mb() * 3 / 4;
+    }
+    if (config_.cpu_budget <= 0.0) {
+        config_.cpu_budget = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (config_.state_dir.empty()) {
+        // a fixed absolute path, so runs started from any directory share one budget
+        config_.state_dir = "/tmp/karaoke-governor";
+    }
+
+    fs::create_directories(config_.state_dir);
+}
+
+fs::path ResourceGovernor::state_path() const {
+    return config_.state_dir / "state.json";
+}
+
+fs::path ResourceGovernor::lock_path() const {
+    return config_.state_dir / "state.lock";
+}
+
+// --state file (callers must hold the lock)--
+
+json ResourceGovernor::load_state() {
+    json state = {{"profiles", json::object()}, {"running", json::array()}, {"queue", json::array()}};
+
+    std::ifstream in(state_path());
+    if (!in.is_open()) return state;
+
+    try {
+        json loaded = json::parse(in);
+        for (const char* key : {"profiles", "running", "queue"}) {
+            if (loaded.contains(key)) state[key] = loaded[key];
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[governor] ignoring corrupt state file: " << e.what() << std::endl;
+    }
+
+    return state;
+}
+
+void ResourceGovernor::save_state(const json& state) {
+    // write then rename so a crash never leaves a half written file
+    fs::path tmp_path = state_path();
+    tmp_path += ".tmp";
+
+    std::ofstream out(tmp_path);
+    if (!out.is_open()) {
+        std::cerr << "[governor] failed to write state: " << tmp_path << std::endl;
+        return;
+    }
+    out << state.dump(2);
+    out.close();
+
+    fs::rename(tmp_path, state_path());
+}
+
+// drop reservations and queue entries left behind by processes that died
+void ResourceGovernor::prune_dead(json& state) {
+    for (const char* key : {"running", "queue"}) {
+        json kept = json::array();
+        for (const auto& entry : state[key]) {
+            if (process_alive(entry.value("pid", 0))) kept.push_back(entry);
+        }
+        state[key] = kept;
+    }
+}
+
+JobUsage ResourceGovernor::estimate_from(const json& state, JobKind kind, size_t units) {
+    JobUsage usage = default_usage(kind);
+
+    const json& profiles = state["profiles"];
+    if (profiles.contains(job_kind_name(kind))) {
+        const json& profile = profiles[job_kind_name(kind)];
+        usage.peak_rss_mb = profile.value("peak_rss_mb", usage.peak_rss_mb);
+        usage.cores = profile.value("cores", usage.cores);
+    }
+
+    usage.peak_rss_mb *= units;
+    usage.cores *= units;
+
+    // a single job may use every core, but never claims more than the budget
+    usage.cores = std::min(usage.cores, config_.cpu_budget);
+    return usage;
+}
+
+JobUsage ResourceGovernor::estimate(JobKind kind, size_t units) {
+    FileLock lock(lock_path());
+    return estimate_from(load_state(), kind, std::max<size_t>(units, 1));
+}
+
+// --admission--
+
+std::string ResourceGovernor::acquire(JobKind kind, size_t units, const std::function<void()>& on_queued) {
+    // ids must be unique across every governor instance in this process
+    static std::atomic<int> next_ticket{0};
+
+    std::stringstream id_ss;
+    id_ss << getpid() << "-" << next_ticket++;
+    std::string id = id_ss.str();
+    units = std::max<size_t>(units, 1);
+
+    bool announced = false;
+
+    while (true) {
+        bool newly_queued = false;
+        {
+            FileLock lock(lock_path());
+            json state = load_state();
+            prune_dead(state);
+
+            JobUsage need = estimate_from(state, kind, units);
+
+            auto& queue = state["queue"];
+            auto queued = std::find_if(queue.begin(), queue.end(),
+                                       [&](const json& entry) { return entry["id"] == id; });
+            if (queued == queue.end()) {
+                queue.push_back({{"id", id}, {"pid", getpid()}, {"kind", job_kind_name(kind)}});
+            }
+
+            double used_mb = 0.0;
+            double used_cores = 0.0;
+            for (const auto& entry : state["running"]) {
+                used_mb += entry.value("mem_mb", 0.0);
+                used_cores += entry.value("cores", 0.0);
+            }
+
+            bool first_in_line = (queue.front()["id"] == id);
+            bool fits = (used_mb + need.peak_rss_mb <= config_.memory_budget_mb) &&
+                        (used_cores + need.cores <= config_.cpu_budget + 1e-6);
+
+            if (first_in_line && (fits || state["running"].empty())) {
+                queue.erase(queue.begin());
+                state["running"].push_back({{"id", id},
+                                            {"pid", getpid()},
+                                            {"kind", job_kind_name(kind)},
+                                            {"mem_mb", need.peak_rss_mb},
+                                            {"cores", need.cores}});
+                save_state(state);
+
+                if (announced) std::cout << "[governor] admitted " << job_kind_name(kind) << std::endl;
+                return id;
+            }
+
+            save_state(state);
+
+            if (!announced) {
+                std::cout << "[governor] queued " << job_kind_name(kind)
+                          << " (needs " << need.peak_rss_mb << " MB, " << need.cores << " cores; "
+                          << "in use " << used_mb << "/" << config_.memory_budget_mb << " MB, "
+                          << used_cores << "/" << config_.cpu_budget << " cores)" << std::endl;
+                announced = true;
+                newly_queued = true;
+            }
+        }
+
+        // outside the lock, the callback may be slow
+        if (newly_queued && on_queued) on_queued();
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(config_.poll_interval));
+    }
+}
+
+void ResourceGovernor::release(const std::string& id, JobKind kind, const std::optional<JobUsage>& usage,
+                               size_t units) {
+    FileLock lock(lock_path());
+    json state = load_state();
+
+    json kept = json::array();
+    for (const auto& entry : state["running"]) {
+        if (entry["id"] != id) kept.push_back(entry);
+    }
+    state["running"] = kept;
+
+    if (usage) {
+        // rise immediately on a bigger run, decay slowly on smaller ones,
+        // so the estimate stays close to the worst recent peak
+        json& profile = state["profiles"][job_kind_name(kind)];
+        auto learn = [&](const char* key, double sample) {
+            if (!profile.contains(key) || sample > profile[key].get<double>()) {
+                profile[key] = sample;
+            } else {
+                profile[key] = profile[key].get<double>() * 0.75 + sample * 0.25;
+            }
+        };
+
+        // profiles are per unit so ladders of any size share one
+        double per_unit = static_cast<double>(std::max<size_t>(units, 1));
+        learn("peak_rss_mb", usage->peak_rss_mb / per_unit);
+        learn("cores", usage->cores / per_unit);
+        profile["runs"] = profile.value("runs", 0) + 1;
+    }
+
+    save_state(state);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <filesystem>
+#include <optional>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+// the kinds of child process the pipeline launches. previews and ladder
+// runs cost very different amounts than a single full render, so each
+// gets its own learned profile
+enum class JobKind {
+    Download,
+    Separator,
+    Render,
+    Preview,
+    Ladder
+};
+
+const char* job_kind_name(JobKind kind);
+
+// measured (or estimated) cost of one child process
+struct JobUsage {
+    double peak_rss_mb = 0.0;
+    double cores = 0.0; // cpu time / wall time
+};
+
+struct GovernorConfig {
+        size_t memory_budget_mb = 0;      // 0 = 75% of physical memory
+        double cpu_budget = 0.0;          // cores, 0 = all hardware threads
+        std::filesystem::path state_dir;  // shared host-wide, empty = /tmp/karaoke-governor
+        double poll_interval = 0.5;       // seconds between admission checks while queued
+    };
+
+// admission control for memory hungry children, shared across processes.
+// reservations and learned per-kind profiles live in a json file guarded
+// by flock, so concurrent karaoke runs on one host see the same budget.
+class ResourceGovernor {
+public:
+    ResourceGovernor(GovernorConfig config = GovernorConfig());
+
+    // blocks until the job fits the budget, returns its reservation id.
+    // jobs are admitted in fifo order; a job is always admitted when
+    // nothing else is running so an oversized estimate cannot deadlock.
+    // units is how many outputs one child produces (ladder targets); the
+    // profile is kept per unit and the reservation scales with it.
+    // on_queued runs once if the job has to wait
+    std::string acquire(JobKind kind, size_t units = 1,
+                        const std::function<void()>& on_queued = nullptr);
+
+    // frees the reservation and folds the measured usage into the profile
+    void release(const std::string& id, JobKind kind, const std::optional<JobUsage>& usage,
+                 size_t units = 1);
+
+    // what the next job of this kind is expected to cost
+    JobUsage estimate(JobKind kind, size_t units = 1);
+
+private:
+    GovernorConfig config_;
+
+    std::filesystem::path state_path() const;
+    std::filesystem::path lock_path() const;
+
+    nlohmann::json load_state();
+    void save_state(const nlohmann::json& state);
+
+    JobUsage estimate_from(const nlohmann::json& state, JobKind kind, size_t units);
+    void prune_dead(nlohmann::json& state);
+};
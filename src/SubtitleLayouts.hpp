@@ -0,0 +1,250 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <ostream>
+#include <cmath>
+#include <algorithm>
+#include "LyricsEngine.hpp"
+
+// subtitle layouts are policy types for AssConverter::generate_with.
+// each one computes its geometry and style block once from the AssConfig
+// and exposes an emit() that writes the dialogue events for one lyric line,
+// so every layout gets its own branch-free emit loop.
+//
+// a layout provides:
+//   explicit Layout(const AssConfig& config);
+//   const std::string& styles() const;          // [V4+ Styles] lines
+//   void emit(std::ostream& out, const EmitContext& ctx) const;
+
+// everything the emit loop has already worked out for line ctx.index
+struct EmitContext {
+    const std::vector<LyricLine>& lines;
+    const std::vector<std::string>& plain_text; // per line, words joined
+    size_t index;
+    const std::string& start_ts;
+    const std::string& end_ts;
+    int dur_ms;
+    int move_start_ms;   // when the exit animation begins
+    int transition_ms;   // fade / move duration, clamped to half the line
+};
+
+// --text helpers--
+
+// plain text of a line, words joined for word level lines
+inline std::string line_plain_text(const LyricLine& line) {
+    if (!line.is_word_level) return line.text;
+
+    std::string s;
+    for (const auto& word : line.words) s += word.text;
+    return s;
+}
+
+// {\kNN} tags per word (or another karaoke tag such as \kf for a sweeping
+// fill); plain text for line level lines
+inline std::string line_karaoke_text(const LyricLine& line, const char* tag = "\\k") {
+    if (!line.is_word_level) return line.text;
+
+    std::stringstream ss;
+
+    for (const auto& word : line.words) {
+        // duration in centiseconds
+        int duration_cs = static_cast<int>((word.end_time - word.start_time) * 100);
+        ss << "{" << tag << duration_cs << "}" << word.text;
+    }
+
+    return ss.str();
+}
+
+// one "Style:" line in the v4+ format used by generate_header
+inline void write_style(std::ostream& out, const char* name, const AssConfig& config, int font_size,
+                        const char* primary, const char* secondary, bool bold,
+                        int outline, int shadow, int margin_lr) {
+    out << "Style: " << name << "," << config.font_name << "," << font_size
+        << "," << primary << "," << secondary << ",&H00000000,&H00000000,"
+        << (bold ? -1 : 0) << ",0,0,0,100,100,0,0,1," << outline << "," << shadow << ",2,"
+        << margin_lr << "," << margin_lr << ",10,1\n";
+}
+
+inline int scaled(double value, double scale) {
+    return static_cast<int>(std::lround(value * scale));
+}
+
+// layouts are designed at 1080p and scale with the short side of the frame
+inline double layout_scale(const AssConfig& config) {
+    return std::min(config.resolution_x, config.resolution_y) / 1080.0;
+}
+
+// --classic 3-line scroll--
+// current line with two faded previews below it; all three move up one
+// slot as the line ends
+
+class ClassicScrollLayout {
+public:
+    explicit ClassicScrollLayout(const AssConfig& config)
+        : ClassicScrollLayout(config,
+                              scaled(config.resolution_y, 520 / 1080.0),
+                              scaled(140, layout_scale(config)),
+                              10) {}
+
+    const std::string& styles() const { return styles_; }
+
+    void emit(std::ostream& out, const EmitContext& ctx) const {
+        const auto& lines = ctx.lines;
+        size_t i = ctx.index;
+
+        // 1. current line event
+
+        // {\move(x1,y1,x2,y2,t1,t2)\fad(t1,t2)}
+        out << "Dialogue: 0," << ctx.start_ts << "," << ctx.end_ts << ",KaraokeCurrent,,0,0,0,,"
+            << "{\\move(" << center_x_ << "," << current_y_ << "," << center_x_ << "," << exit_y_ << ","
+            << ctx.move_start_ms << "," << ctx.dur_ms << ")"
+            << "\\fad(0," << ctx.transition_ms << ")}"
+            << line_karaoke_text(lines[i]) << "\n";
+
+        // 2. next line event (preview)
+        if (i + 1 < lines.size()) {
+            out << "Dialogue: 0," << ctx.start_ts << "," << ctx.end_ts << ",KaraokeNext,,0,0,0,,"
+                << "{\\move(" << center_x_ << "," << next_y_ << "," << center_x_ << "," << current_y_ << ","
+                << ctx.move_start_ms << "," << ctx.dur_ms << ")}"
+                << ctx.plain_text[i + 1] << "\n";
+        }
+
+        // 3. next2 line event (preview)
+        if (i + 2 < lines.size()) {
+            out << "Dialogue: 0," << ctx.start_ts << "," << ctx.end_ts << ",KaraokeNext2,,0,0,0,,"
+                << "{\\move(" << center_x_ << "," << next2_y_ << "," << center_x_ << "," << next_y_ << ","
+                << ctx.move_start_ms << "," << ctx.dur_ms << ")"
+                << "\\fad(" << ctx.transition_ms << ",0)}"
+                << ctx.plain_text[i + 2] << "\n";
+        }
+    }
+
+protected:
+    ClassicScrollLayout(const AssConfig& config, int current_y, int spacing, int margin_lr)
+        : center_x_(config.resolution_x / 2),
+          current_y_(current_y),
+          exit_y_(current_y - scaled(120, layout_scale(config))), // current line moves up before leaving
+          next_y_(current_y + spacing),
+          next2_y_(current_y + 2 * spacing) {
+
+        std::stringstream ss;
+        // current line style (white, larger)
+        write_style(ss, "KaraokeCurrent", config, config.font_size_current,
+                    "&H00FFFFFF", "&H00FFFFFF", true, 3, 3, margin_lr);
+        // next line style (faded white)
+        write_style(ss, "KaraokeNext", config, config.font_size_next,
+                    "&H88FFFFFF", "&H00FFFFFF", false, 2, 2, margin_lr);
+        // next2 line style (more faded)
+        write_style(ss, "KaraokeNext2", config, config.font_size_next2,
+                    "&H66FFFFFF", "&H00FFFFFF", false, 1, 1, margin_lr);
+        styles_ = ss.str();
+    }
+
+private:
+    int center_x_;
+    int current_y_;
+    int exit_y_;
+    int next_y_;
+    int next2_y_;
+    std::string styles_;
+};
+
+// --vertical 9:16--
+// the classic scroll, centred in a tall frame with line spacing tied to the
+// font size and wide side margins so long lines wrap instead of clipping
+
+class VerticalLayout : public ClassicScrollLayout {
+public:
+    explicit VerticalLayout(const AssConfig& config)
+        : ClassicScrollLayout(config,
+                              config.resolution_y / 2,
+                              std::max(config.font_size_current, config.font_size_next) * 3,
+                              config.resolution_x * 8 / 100) {}
+};
+
+// --2-line duet--
+// lines alternate between a top and a bottom slot; the line being sung is
+// highlighted while the other slot already shows the line that follows
+
+class DuetLayout {
+public:
+    explicit DuetLayout(const AssConfig& config)
+        : center_x_(config.resolution_x / 2),
+          slot_y_{scaled(config.resolution_y, 470 / 1080.0),
+                  scaled(config.resolution_y, 470 / 1080.0) + scaled(140, layout_scale(config))} {
+
+        std::stringstream ss;
+        // line being sung: white fill sweeping over a faded base
+        write_style(ss, "DuetCurrent", config, config.font_size_current,
+                    "&H00FFFFFF", "&H88FFFFFF", true, 3, 3, 10);
+        // waiting line in the other slot
+        write_style(ss, "DuetNext", config, config.font_size_next,
+                    "&H88FFFFFF", "&H88FFFFFF", false, 2, 2, 10);
+        styles_ = ss.str();
+    }
+
+    const std::string& styles() const { return styles_; }
+
+    void emit(std::ostream& out, const EmitContext& ctx) const {
+        const auto& lines = ctx.lines;
+        size_t i = ctx.index;
+        int slot = static_cast<int>(i % 2);
+
+        out << "Dialogue: 0," << ctx.start_ts << "," << ctx.end_ts << ",DuetCurrent,,0,0,0,,"
+            << "{\\pos(" << center_x_ << "," << slot_y_[slot] << ")}"
+            << line_karaoke_text(lines[i]) << "\n";
+
+        if (i + 1 < lines.size()) {
+            out << "Dialogue: 0," << ctx.start_ts << "," << ctx.end_ts << ",DuetNext,,0,0,0,,"
+                << "{\\pos(" << center_x_ << "," << slot_y_[1 - slot] << ")"
+                << "\\fad(" << ctx.transition_ms << ",0)}"
+                << ctx.plain_text[i + 1] << "\n";
+        }
+    }
+
+private:
+    int center_x_;
+    int slot_y_[2];
+    std::string styles_;
+};
+
+// --single line word highlight--
+// one centred line; words fill with colour as they are sung. line level
+// lyrics get a single sweep over the whole line
+
+class WordHighlightLayout {
+public:
+    explicit WordHighlightLayout(const AssConfig& config)
+        : center_x_(config.resolution_x / 2),
+          center_y_(config.resolution_y / 2) {
+
+        std::stringstream ss;
+        // sung text turns yellow, unsung text stays white
+        write_style(ss, "KaraokeHighlight", config, config.font_size_current,
+                    "&H0000FFFF", "&H00FFFFFF", true, 3, 3, 10);
+        styles_ = ss.str();
+    }
+
+    const std::string& styles() const { return styles_; }
+
+    void emit(std::ostream& out, const EmitContext& ctx) const {
+        const LyricLine& line = ctx.lines[ctx.index];
+
+        out << "Dialogue: 0," << ctx.start_ts << "," << ctx.end_ts << ",KaraokeHighlight,,0,0,0,,"
+            << "{\\pos(" << center_x_ << "," << center_y_ << ")"
+            << "\\fad(" << ctx.transition_ms << "," << ctx.transition_ms << ")}";
+
+        if (line.is_word_level) {
+            out << line_karaoke_text(line, "\\kf") << "\n";
+        } else {
+            out << "{\\kf" << ctx.dur_ms / 10 << "}" << line.text << "\n";
+        }
+    }
+
+private:
+    int center_x_;
+    int center_y_;
+    std::string styles_;
+};
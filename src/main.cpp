@@ -1,138 +1,211 @@
 #include <iostream>
 #include <string>
 #include <filesystem>
-#include <ExternalTools.hpp>
-#include <LyricsEngine.hpp>
+#include <optional>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <memory>
+#include <cmath>
+#include <Pipeline.hpp>
 
 namespace fs = std::filesystem;
 
-std::string sanitize_filename(std::string name) {
-    std::string invalid_chars = "\\/:?\"<>|";
-    for (char& c : name) {
-        if (invalid_chars.find(c) != std::string::npos) {
-            c = '_';
+void print_usage() {
+    std::cout << "usage: ./karaoke [--preview] [--preview-lines n] [--preview-start s] [--preview-duration s] "
+              << "[--layout classic|duet|vertical|word] [--ladder] [--stream hls|fmp4] [--segment-duration s] "
+              << "[--mem-budget mb] [--cpu-budget cores] [--governor-dir path] "
+              << "[--progress-fd n | --progress-socket path] "
+              << "<youtube_url_or_search_term>" << std::endl;
+}
+
+// strict numeric flag values: the whole string must parse. every flag is a
+// count, time, budget or fd, so negative and non-finite values are rejected
+template <typename T>
+std::optional<T> parse_number(const std::string& text) {
+    try {
+        size_t used = 0;
+        T value;
+        if constexpr (std::is_floating_point_v<T>) {
+            double parsed = std::stod(text, &used);
+            if (!std::isfinite(parsed) || parsed < 0.0) return std::nullopt;
+            value = static_cast<T>(parsed);
+        } else {
+            if (!text.empty() && text[0] == '-') return std::nullopt;
+            value = static_cast<T>(std::stoul(text, &used));
         }
+        if (used != text.size()) return std::nullopt;
+        return value;
+    } catch (...) {
+        return std::nullopt;
     }
-
-    return name;
 }
 
 int main(int argc, char* argv[]) {
 
-    if (argc < 2) {
-        std::cout << "usage: ./karaoke <youtube_url_or_search_term>" << std::endl;
-        return 1;
-    }
-
-    std::string input = argv[1];
-
-    // if input doesnt look like a url, treat it as a search
-    if (input.find("http") == std::string::npos) {
-        input = "ytsearch1:\"" + input + "\"";
-    }
-
-
-    std::cout << "--full pipeline--" << std::endl;
-    
-    ExternalTools tools;
-    LyricsFetcher lyrics_fetcher;
-    AssConverter ass_converter;
-
-    // create hash of input string to use as folder name
-    size_t input_hash = std::hash<std::string>{}(input);
-    std::string project_id = std::to_string(input_hash);
-
-    fs::path project_dir = fs::path("artifacts") / project_id;
-    fs::create_directories(project_dir);
-
-    fs::path p_source_wav =       project_dir / "source.wav";
-    fs::path p_instrumental_wav = project_dir / "instrumental.wav";
-    fs::path p_subtitles_ass =    project_dir / "karaoke.ass";
-
-    std::cout << "project id: " << project_id << std::endl;
-    std::cout << "artificats: " << project_dir << std::endl;
+    std::string input;
+    PipelineOptions options;
+    GovernorConfig governor_config;
+    AssConfig ass_config;
+    auto progress = std::make_shared<ProgressReporter>();
+    std::optional<double> segment_duration; // applied after parsing so flag order does not matter
+
+    const std::vector<std::string> value_flags = {
+        "--preview-lines", "--preview-start", "--preview-duration", "--mem-budget", "--cpu-budget", "--governor-dir",
+        "--layout", "--progress-fd", "--progress-socket", "--stream", "--segment-duration"
+    };
+
+    // reports a bad flag value and yields nullopt so callers can bail out
+    auto number_arg = [&](const std::string& flag, const std::string& text, auto tag) {
+        auto value = parse_number<decltype(tag)>(text);
+        if (!value) std::cerr << "invalid value for " << flag << ": " << text << std::endl;
+        return value;
+    };
+
+    // same, for counts and durations where zero makes no sense
+    auto positive_arg = [&](const std::string& flag, const std::string& text, auto tag) {
+        auto value = number_arg(flag, text, tag);
+        if (value && *value == 0) {
+            std::cerr << flag << " must be greater than 0" << std::endl;
+            return decltype(value)();
+        }
+        return value;
+    };
 
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
 
-    // 1. get metadata
-    std::cout << "\n [1/5] fetching metadata..." << std::endl;
+        bool takes_value = std::find(value_flags.begin(), value_flags.end(), arg) != value_flags.end();
+        if (takes_value && i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << std::endl;
+            print_usage();
+            return 1;
+        }
 
-    auto metadata_opt = tools.get_youtube_metadata(input);
-    if (!metadata_opt) {
-        std::cerr << "failed to get metadata" << std::endl;
-        return 1;
+        if (arg == "--preview") {
+            options.preview = true;
+        } else if (arg == "--preview-lines") {
+            auto value = positive_arg(arg, argv[++i], size_t{});
+            if (!value) return 1;
+            options.preview = true;
+            options.preview_lines = *value;
+        } else if (arg == "--preview-start") {
+            auto value = number_arg(arg, argv[++i], double{});
+            if (!value) return 1;
+            options.preview = true;
+            options.preview_options.start_time = *value;
+        } else if (arg == "--preview-duration") {
+            auto value = positive_arg(arg, argv[++i], double{});
+            if (!value) return 1;
+            options.preview = true;
+            options.preview_options.duration = *value;
+        } else if (arg == "--mem-budget") {
+            auto value = number_arg(arg, argv[++i], size_t{});
+            if (!value) return 1;
+            governor_config.memory_budget_mb = *value;
+        } else if (arg == "--cpu-budget") {
+            auto value = number_arg(arg, argv[++i], double{});
+            if (!value) return 1;
+            governor_config.cpu_budget = *value;
+        } else if (arg == "--governor-dir") {
+            governor_config.state_dir = argv[++i];
+        } else if (arg == "--layout") {
+            std::string layout = argv[++i];
+            if (layout == "classic") {
+                ass_config.layout = SubtitleLayout::ClassicScroll;
+            } else if (layout == "duet") {
+                ass_config.layout = SubtitleLayout::Duet;
+            } else if (layout == "vertical") {
+                ass_config.layout = SubtitleLayout::Vertical;
+            } else if (layout == "word") {
+                ass_config.layout = SubtitleLayout::WordHighlight;
+            } else {
+                std::cerr << "unknown layout: " << layout << " (expected classic, duet, vertical or word)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--progress-fd") {
+            auto value = number_arg(arg, argv[++i], size_t{});
+            if (!value) return 1;
+            if (*value <= 2) {
+                std::cerr << "--progress-fd must be 3 or higher; 0-2 carry logs and child output" << std::endl;
+                print_usage();
+                return 1;
+            }
+            if (!progress->open_fd(static_cast<int>(*value))) {
+                std::cerr << "progress fd " << *value << " is not open" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--progress-socket") {
+            std::string socket_path = argv[++i];
+            if (!progress->open_socket(socket_path)) {
+                std::cerr << "failed to open progress socket: " << socket_path << std::endl;
+                return 1;
+            }
+        } else if (arg == "--ladder") {
+            options.ladder = true;
+        } else if (arg == "--stream") {
+            std::string format = argv[++i];
+            StreamOptions stream;
+            if (format == "hls") {
+                stream.format = StreamFormat::Hls;
+            } else if (format == "fmp4") {
+                stream.format = StreamFormat::FragmentedMp4;
+            } else {
+                std::cerr << "unknown stream format: " << format << " (expected hls or fmp4)" << std::endl;
+                return 1;
+            }
+            options.stream_options = stream;
+        } else if (arg == "--segment-duration") {
+            auto value = positive_arg(arg, argv[++i], double{});
+            if (!value) return 1;
+            segment_duration = *value;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "unknown option: " << arg << std::endl;
+            print_usage();
+            return 1;
+        } else {
+            input = arg;
+        }
     }
 
-    VideoMetadata meta = *metadata_opt;
-
-    std::cout << "  title:  " << meta.title << std::endl;
-    std::cout << "  artist  " << meta.artist << std::endl;
-    
-    if (meta.artist.empty()) {
-        std::cout << "artist detection failed. using title as query.." << std::endl;
+    if (input.empty()) {
+        print_usage();
+        return 1;
     }
 
-    // 2. download audio
-    std::cout << "\n[2/5] downloading audio..." << std::endl;
-    auto audio_path = tools.download_audio(input, p_source_wav);
-    if (!audio_path) return 1;
-
-    // 3. separate audio 
-
-    std::cout << "\n[3/5] separating vocals..." << std::endl;
-    auto final_audio_path = *audio_path;
-
-    // check if separator binary exists
-    if (std::filesystem::exists("./separator")) {
-        auto separated_path = tools.run_separator(*audio_path, p_instrumental_wav);
-        if (separated_path) {
-            final_audio_path = *separated_path;
-            std::cout << " separation complete" << std::endl;
-        } else {
-            std::cerr << " separation failed. using original audio" << std::endl;
+    if (segment_duration) {
+        if (!options.stream_options) {
+            std::cerr << "--segment-duration requires --stream" << std::endl;
+            return 1;
         }
-    } else {
-        std::cerr << " separator binary not found, using original audio" << std::endl;
+        options.stream_options->segment_duration = *segment_duration;
     }
 
-    // fetch and process lyrics
-
-    std::cout << "\n[4/5] fetching lyrics..." << std::endl;
-
-    auto lrc_opt = lyrics_fetcher.fetch_lyrics(meta.artist, meta.title);
-
-    if (!lrc_opt && meta.artist.empty()) {
-        // try fetching with just title if artist is empty
-        lrc_opt = lyrics_fetcher.fetch_lyrics("", meta.title);
+    // preview stops before the full render, so render-only flags would be ignored
+    if (options.preview && (options.ladder || options.stream_options)) {
+        std::cerr << "--preview cannot be combined with --ladder or --stream" << std::endl;
+        return 1;
     }
 
-    if (!lrc_opt) {
-        std::cerr << "lyrics not found. proceeding with instrumental video" << std::endl;
-        lrc_opt = "[00:00.00] (Instrumental / Lyrics not found)";
+    if (options.ladder && options.stream_options) {
+        std::cerr << "--ladder and --stream cannot be combined" << std::endl;
+        return 1;
     }
 
-    std::cout << " parsing lyrics..." << std::endl;
-
-    auto lines = ass_converter.parse_lrc(*lrc_opt);
-
-    std::string ass_content = ass_converter.generate_ass(lines);
-    ass_converter.save_to_file(ass_content, p_subtitles_ass);
-
-    // 5. render videos
-    std::string safe_title = sanitize_filename(meta.title);
-    if (!meta.artist.empty()) safe_title = sanitize_filename(meta.artist) + " - " + safe_title;
+    std::cout << "--full pipeline--" << std::endl;
 
-    fs::path output_dir = "output";
-    fs::create_directories(output_dir);
+    ExternalTools tools(Paths(), governor_config);
+    tools.set_progress_reporter(progress);
+    LyricsFetcher lyrics_fetcher;
+    AssConverter ass_converter(ass_config);
 
-    // video 1: instrumental
-    fs::path out_vid_inst = output_dir / (safe_title + " (instrumental).mp4");
-    std::cout << "rendering instrumental video..." << std::endl;
-    tools.render_video(final_audio_path, p_subtitles_ass, out_vid_inst);
+    PipelineResult result = run_pipeline(input, options, tools, lyrics_fetcher, ass_converter);
 
-    // video 2 : original audio
-    fs::path out_vid_orig = output_dir / (safe_title + " (original).mp4");
-    std::cout << "rendering original video..." << std::endl;
-    tools.render_video(p_source_wav, p_subtitles_ass, out_vid_orig);
+    std::cout << "\ntimings:" << std::endl;
+    for (const auto& stage : result.stages) {
+        std::cout << "  " << stage.stage << ": " << stage.seconds << "s" << std::endl;
+    }
+    std::cout << "  total: " << result.total_seconds << "s" << std::endl;
 
-    return 0;
+    return result.success ? 0 : 1;
 }
\ No newline at end of file